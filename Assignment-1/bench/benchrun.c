@@ -0,0 +1,155 @@
+#define    _GNU_SOURCE
+#include    <fcntl.h>
+#include    <linux/perf_event.h>
+#include    <stdint.h>
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <sys/resource.h>
+#include    <sys/stat.h>
+#include    <sys/syscall.h>
+#include    <sys/wait.h>
+#include    <time.h>
+#include    <unistd.h>
+
+/*
+ * benchrun.c
+ *   purpose: run one filter over one input file and report how it did
+ *     usage: benchrun name input -- command [args ...]
+ *            runs command < input > /dev/null
+ *    output: one JSON object per run on stdout:
+ *              {"tool":..., "args":..., "input":..., "bytes":..., "seconds":...,
+ *               "mb_per_s":..., "instructions":..., "instructions_per_byte":...,
+ *               "max_rss_kb":..., "status":...}
+ *            instructions are counted with perf_event_open over the command
+ *            and any threads it starts; they are null when the kernel does
+ *            not allow it (see /proc/sys/kernel/perf_event_paranoid)
+ *    errors: returns 2 on bad usage, 1 if the command could not be run
+ */
+
+static int open_counter(pid_t);
+
+static void print_json_string(const char *);
+
+int main(int argc, char *argv[]) {
+    struct stat st;
+    struct rusage ru;
+    struct timespec t0, t1;
+    uint64_t instructions = 0;
+    int go[2], in, out, counter, status, i;
+    double seconds;
+    char args[1024] = "";
+    char c = 0;
+    pid_t pid;
+
+    if (argc < 5 || strcmp(argv[3], "--") != 0) {
+        fprintf(stderr, "usage: benchrun name input -- command [args ...]\n");
+        return 2;
+    }
+    if ((in = open(argv[2], O_RDONLY)) < 0 || fstat(in, &st) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    if ((out = open("/dev/null", O_WRONLY)) < 0 || pipe(go) != 0) {
+        perror("benchrun");
+        return 1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        perror("benchrun: fork");
+        return 1;
+    }
+    if (pid == 0) {
+        /* wait until the counter is attached, then become the command */
+        close(go[1]);
+        if (read(go[0], &c, 1) != 1)
+            _exit(127);
+        dup2(in, 0);
+        dup2(out, 1);
+        execvp(argv[4], argv + 4);
+        perror(argv[4]);
+        _exit(127);
+    }
+
+    close(go[0]);
+    counter = open_counter(pid);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (write(go[1], &c, 1) != 1) {
+        perror("benchrun");
+        return 1;
+    }
+    close(go[1]);
+    if (wait4(pid, &status, 0, &ru) < 0) {
+        perror("benchrun: wait4");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (counter >= 0 && read(counter, &instructions, sizeof(instructions)) != sizeof(instructions))
+        counter = -1;
+
+    /* the command's arguments, as one string */
+    for (i = 5; i < argc; i++) {
+        if (i > 5)
+            strncat(args, " ", sizeof(args) - strlen(args) - 1);
+        strncat(args, argv[i], sizeof(args) - strlen(args) - 1);
+    }
+    seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("{\"tool\": ");
+    print_json_string(argv[1]);
+    printf(", \"args\": ");
+    print_json_string(args);
+    printf(", \"input\": ");
+    print_json_string(argv[2]);
+    printf(", \"bytes\": %lld, \"seconds\": %.6f, \"mb_per_s\": %.2f",
+           (long long) st.st_size, seconds, st.st_size / seconds / 1e6);
+    if (counter >= 0)
+        printf(", \"instructions\": %llu, \"instructions_per_byte\": %.3f",
+               (unsigned long long) instructions,
+               st.st_size > 0 ? (double) instructions / st.st_size : 0.0);
+    else
+        printf(", \"instructions\": null, \"instructions_per_byte\": null");
+    printf(", \"max_rss_kb\": %ld, \"status\": %d}\n",
+           ru.ru_maxrss, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 127;
+}
+
+static int open_counter(pid_t pid)
+/*
+ * purpose: count user space instructions of `pid' and its threads from
+ *          its next exec onwards
+ * returns: the counter's descriptor, -1 if perf events are not available
+ */
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+static void print_json_string(const char *s)
+/*
+ * purpose: print `s' as a quoted JSON string
+ */
+{
+    putchar('"');
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            printf("\\%c", *s);
+        else if ((unsigned char) *s < 0x20)
+            printf("\\u%04x", (unsigned char) *s);
+        else
+            putchar(*s);
+    }
+    putchar('"');
+}
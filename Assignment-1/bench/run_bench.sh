@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# run_bench.sh
+#   purpose: generate schedule files of several sizes and run every filter
+#            over each of them through benchrun
+#     usage: run_bench.sh bindir datadir [size ...]
+#            bindir holds the tools, schedgen and benchrun; datadir gets the
+#            generated inputs, which are reused when they already exist.
+#            sizes default to 1M 64M and take schedgen's K, M, G suffixes.
+#            These environment variables shape the input and the runs:
+#              BENCH_EXTRA  extra fields per record        (default 0)
+#              BENCH_EMPTY  fraction of empty fields       (default 0.001)
+#              BENCH_BAD    fraction of invalid TI values  (default 0.001)
+#              BENCH_JOBS   also run the -j tools with this many threads
+#    output: one JSON object per run, see benchrun.c
+#
+
+BIN=${1:?usage: $0 bindir datadir [size ...]}
+DATA=${2:?usage: $0 bindir datadir [size ...]}
+shift 2
+[ $# -eq 0 ] && set -- 1M 64M
+
+EXTRA=${BENCH_EXTRA:-0}
+EMPTY=${BENCH_EMPTY:-0.001}
+BAD=${BENCH_BAD:-0.001}
+
+mkdir -p "$DATA" || exit 1
+
+for size in "$@"; do
+    input=$DATA/sched-$size-f$EXTRA-e$EMPTY-b$BAD.txt
+    if [ ! -s "$input" ]; then
+        "$BIN/schedgen" -s "$size" -f "$EXTRA" -e "$EMPTY" -b "$BAD" > "$input" || exit 1
+    fi
+
+    for tool in semi2tab2 rmtags uniqc empties badtime; do
+        "$BIN/benchrun" "$tool" "$input" -- "$BIN/$tool"
+    done
+    "$BIN/benchrun" semi2tab2 "$input" -- "$BIN/semi2tab2" -s
+    "$BIN/benchrun" uniqc "$input" -- "$BIN/uniqc" -z
+    "$BIN/benchrun" uniqc "$input" -- "$BIN/uniqc" -s
+    "$BIN/benchrun" uniqc "$input" -- "$BIN/uniqc" -r
+    "$BIN/benchrun" rmtags "$input" -- "$BIN/rmtags" -k TI,stn,Line
+
+    if [ -n "$BENCH_JOBS" ]; then
+        for tool in semi2tab2 rmtags empties badtime; do
+            "$BIN/benchrun" "$tool" "$input" -- "$BIN/$tool" -j "$BENCH_JOBS"
+        done
+    fi
+done
@@ -0,0 +1,155 @@
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <stdint.h>
+
+/*
+ * schedgen.c
+ *   purpose: write a synthetic schedule file shaped like sched.txt,
+ *              TR=002;dir=i;day=m-f;TI=05:20;stn=bridgewater;Line=middleborough
+ *            for benchmarking the Assignment-1 filters
+ *     usage: schedgen [-s size] [-f extra] [-e rate] [-b rate] [-r seed] > out
+ *            -s  bytes to write, with an optional K, M or G suffix (default 1M)
+ *            -f  extra xN=value fields per record, 0 to 32 (default 0)
+ *            -e  fraction of fields left empty, e.g. 0.001 (default 0)
+ *            -b  fraction of records with an invalid TI (default 0)
+ *            -r  seed, so runs can be repeated (default 1)
+ *    output: whole records until at least `size' bytes have been written
+ *    errors: returns 2 on a bad argument, 1 if stdout can not be written
+ */
+
+#define    MAX_EXTRA    32
+#define    RECSIZE      1024
+
+static const char *dirs[] = {"i", "o"};
+static const char *days[] = {"m-f", "sa", "su"};
+static const char *stations[] = {
+        "south station", "back bay", "ruggles", "forest hills", "hyde park",
+        "readville", "route 128", "canton junction", "sharon", "mansfield",
+        "attleboro", "providence", "middleborough/ lakeville", "bridgewater",
+        "campello", "brockton", "montello", "holbrook/ randolph", "braintree",
+        "quincy center", "jfk/umass", "north station", "salem", "beverly",
+        "reading", "north wilmington", "lowell", "fitchburg", "worcester"
+};
+static const char *lines[] = {
+        "middleborough", "providence", "franklin", "fairmount", "newburyport",
+        "haverhill", "lowell", "fitchburg", "worcester", "needham"
+};
+static const char *bad_times[] = {"24:01", "13:2", "17;48", "10:3O", "25:00", "09:60", ":24"};
+
+#define    COUNT(a)    (sizeof(a) / sizeof((a)[0]))
+
+static uint64_t state;
+
+static uint64_t next_random(void);
+
+static int chance(double);
+
+static int put_field(char *, int, const char *, const char *, double);
+
+int main(int argc, char *argv[]) {
+    unsigned long long size = 1 << 20, written = 0;
+    int extra = 0;
+    double empty_rate = 0, bad_rate = 0;
+    char rec[RECSIZE], value[32], key[12];
+    char *end;
+    int i, n, train = 0;
+
+    state = 1;
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc)
+            goto usage;
+        switch (argv[i++][1]) {
+            case 's':
+                size = strtoull(argv[i], &end, 10);
+                if (*end == 'K' || *end == 'k')
+                    size <<= 10;
+                else if (*end == 'M' || *end == 'm')
+                    size <<= 20;
+                else if (*end == 'G' || *end == 'g')
+                    size <<= 30;
+                break;
+            case 'f':
+                extra = atoi(argv[i]);
+                if (extra < 0 || extra > MAX_EXTRA)
+                    goto usage;
+                break;
+            case 'e':
+                empty_rate = atof(argv[i]);
+                break;
+            case 'b':
+                bad_rate = atof(argv[i]);
+                break;
+            case 'r':
+                state = strtoull(argv[i], NULL, 10) | 1;
+                break;
+            default:
+                goto usage;
+        }
+    }
+
+    while (written < size) {
+        /* a train stops at a handful of stations, minutes apart */
+        if (next_random() % 8 == 0)
+            train = (int) (next_random() % 3000);
+
+        n = 0;
+        sprintf(value, "%03d", train);
+        n = put_field(rec, n, "TR", value, empty_rate);
+        n = put_field(rec, n, "dir", dirs[next_random() % COUNT(dirs)], empty_rate);
+        n = put_field(rec, n, "day", days[next_random() % COUNT(days)], empty_rate);
+        if (chance(bad_rate))
+            n = put_field(rec, n, "TI", bad_times[next_random() % COUNT(bad_times)], 0);
+        else {
+            sprintf(value, "%02d:%02d", (int) (next_random() % 24), (int) (next_random() % 60));
+            n = put_field(rec, n, "TI", value, empty_rate);
+        }
+        n = put_field(rec, n, "stn", stations[next_random() % COUNT(stations)], empty_rate);
+        n = put_field(rec, n, "Line", lines[next_random() % COUNT(lines)], empty_rate);
+        for (i = 0; i < extra; i++) {
+            sprintf(key, "x%d", i);
+            sprintf(value, "%u", (unsigned) (next_random() % 100000));
+            n = put_field(rec, n, key, value, empty_rate);
+        }
+        rec[n - 1] = '\n';      /* the last ';' ends the record */
+
+        if (fwrite(rec, 1, n, stdout) != (size_t) n) {
+            perror("schedgen");
+            return 1;
+        }
+        written += n;
+    }
+    return fflush(stdout) == 0 ? 0 : 1;
+
+usage:
+    fprintf(stderr, "usage: schedgen [-s size] [-f extra] [-e rate] [-b rate] [-r seed]\n");
+    return 2;
+}
+
+static uint64_t next_random(void)
+/*
+ * purpose: xorshift64, so a seed gives the same file everywhere
+ */
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static int chance(double rate)
+/*
+ * returns: 1 with probability `rate'
+ */
+{
+    return rate > 0 && (double) (next_random() >> 11) / (double) (1ULL << 53) < rate;
+}
+
+static int put_field(char *rec, int n, const char *key, const char *value, double empty_rate)
+/*
+ * purpose: append key=value; at rec[n], leaving the value out at `empty_rate'
+ * returns: the new length
+ */
+{
+    return n + sprintf(rec + n, "%s=%s;", key, chance(empty_rate) ? "" : value);
+}
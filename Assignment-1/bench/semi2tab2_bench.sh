@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# semi2tab2_bench.sh
+#   purpose: compare the block filter in semi2tab2 against the original
+#            getchar/putchar loop (-s) on a scaled-up copy of sched.txt
+#     usage: semi2tab2_bench.sh path/to/semi2tab2 [copies]
+#            copies defaults to 2000 (roughly 1 GB of input)
+#
+
+BIN=${1:?usage: $0 path/to/semi2tab2 [copies]}
+COPIES=${2:-2000}
+SCHED=$(dirname "$0")/../sched.txt
+DATA=${TMPDIR:-/tmp}/semi2tab2_bench.$$
+
+trap 'rm -f "$DATA" "$DATA.s" "$DATA.b"' EXIT INT TERM
+
+i=0
+while [ "$i" -lt "$COPIES" ]; do
+    cat "$SCHED"
+    i=$((i + 1))
+done > "$DATA"
+
+BYTES=$(wc -c < "$DATA")
+
+run() {
+    # run <label> <outfile> [flag]: prints label, seconds and MB/s
+    start=$(date +%s.%N)
+    "$BIN" $3 < "$DATA" > "$2"
+    end=$(date +%s.%N)
+    echo "$1 $start $end $BYTES" |
+        awk '{ t = $3 - $2; printf "%-8s %8.3f s %10.1f MB/s\n", $1, t, $4 / t / 1e6 }'
+}
+
+run stream "$DATA.s" -s
+run block "$DATA.b"
+
+if cmp -s "$DATA.s" "$DATA.b"; then
+    echo "outputs match ($BYTES bytes)"
+else
+    echo "outputs differ" >&2
+    exit 1
+fi
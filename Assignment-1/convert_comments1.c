@@ -5,7 +5,6 @@
 
 int main() {
 
-    int reader = 0;
     int isCommentAnticipated = false;
     int isCommentFound = false;
     int hasCommentEnded = false;
@@ -13,59 +12,55 @@ int main() {
     char line[MAX_SIZE];
     char prev;
 
-    //Loop until EOF
-    while ((reader = getchar()) != EOF) {
-        ungetc(reader, stdin);
-        // Loop until EOL
-        if (fgets(line, MAX_SIZE, stdin)) {
+    //Loop until EOF; fgets returns NULL there, so there is no need to peek and push back
+    while (fgets(line, MAX_SIZE, stdin)) {
 
-            for (int i = 0; i < MAX_SIZE; i++) {
+        for (int i = 0; i < MAX_SIZE; i++) {
 
-                while (line[i] != '/' && !isCommentAnticipated && !isCommentFound) {
-                    i++;
-                }
-
-                if (line[i] == '/' && !isCommentAnticipated) {
-                    isCommentAnticipated = true;
-                    prev = line[i];
-                    continue;
-                }
+            while (line[i] != '/' && !isCommentAnticipated && !isCommentFound) {
+                i++;
+            }
 
-                if (prev != line[i]){
-                    isCommentAnticipated = false;
-                    isAlreadyCommented= true;
-                }
+            if (line[i] == '/' && !isCommentAnticipated) {
+                isCommentAnticipated = true;
+                prev = line[i];
+                continue;
+            }
 
-                if (prev == '/' && line[i] == '*'){
-                    break;
-                }
+            if (prev != line[i]){
+                isCommentAnticipated = false;
+                isAlreadyCommented= true;
+            }
 
+            if (prev == '/' && line[i] == '*'){
+                break;
+            }
 
-                if (line[i] == '/' && isCommentAnticipated && prev == '/') {
-                    isCommentFound = true;
-                    line[i] = '*';
-                }
 
-                // Means everything is a comment
-                if (isCommentAnticipated && isCommentFound && line[i] == '\n') {
-                    line[i] = ' ';
-                    line[++i] = '*';
-                    line[++i] = '/';
-                    line[++i] = '\n';
-                    hasCommentEnded = true;
-                }
+            if (line[i] == '/' && isCommentAnticipated && prev == '/') {
+                isCommentFound = true;
+                line[i] = '*';
+            }
 
+            // Means everything is a comment
+            if (isCommentAnticipated && isCommentFound && line[i] == '\n') {
+                line[i] = ' ';
+                line[++i] = '*';
+                line[++i] = '/';
+                line[++i] = '\n';
+                hasCommentEnded = true;
             }
 
-            if (hasCommentEnded || isAlreadyCommented) {
+        }
 
-                printf("%s", line);
-                isCommentAnticipated = false;
-                isCommentFound = false;
-                hasCommentEnded = false;
-            }
+        if (hasCommentEnded || isAlreadyCommented) {
 
+            printf("%s", line);
+            isCommentAnticipated = false;
+            isCommentFound = false;
+            hasCommentEnded = false;
         }
+
     }
 
     return 0;
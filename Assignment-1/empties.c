@@ -1,47 +1,187 @@
 #include    <stdio.h>
+#include    <stdint.h>
+#include    <string.h>
+#include    "linereader.h"
+#include    "parallel.h"
+
+#ifdef __SSE2__
+#include    <emmintrin.h>
+#endif
 
 /*
  *	empties.c
  *		assume lines look like
  *			XX=stuff;YY=morestuff;..;ZZ=yetmorestuff
  *		print lines that have one or more empty fields
- *		compile with readln.c
- *		Returns 0 for no empties, 1 for found some
+ *		compile with linereader.c; lines may be of any length
+ *		usage: empties [-j N] < input; -j scans on N threads
+ *		Returns 0 for no empties, 1 for found some, 2 if stdin
+ *		could not be read
  */
 
-#define    LINESIZE    512
-#define    TRUE        1
-#define    FALSE        0
 #define    DELIM        ';'
+#define    CHUNK        64
+#define    MAXHITS        1024
+
+size_t find_empties(const char *, size_t, size_t [], size_t);
 
-int has_empty(char []);
+void put_line(const char *, const char *);
 
-int readln(char [], int, char);
+size_t empties_chunk(const char *, size_t, char *, void *);
 
-int main() {
-    char line[LINESIZE];        /* an array of characters */
+int main(int argc, char *argv[]) {
+    struct line_reader lr;        /* hands out blocks of whole lines */
+    const char *block, *nl;
+    size_t len, n, i, done;
+    size_t hits[MAXHITS];        /* offsets of lines with empties  */
     int rv = 0;            /* passed back to shell	  */
+    int jobs = par_take_jobs(&argc, argv);
+
+    if (jobs > 1) {
+        rv = par_filter(0, 1, jobs, 1, empties_chunk, NULL);
+        return rv < 0 ? 2 : rv;
+    }
+
+    if (lr_init(&lr, 0) != 0)
+        return 2;
 
-    while (readln(line, LINESIZE, '\n') != 0)
-        if (has_empty(line) == TRUE) {
-            puts(line);
+    while (lr_block(&lr, &block, &len) != 0)
+        for (done = 0; done < len; done += hits[n - 1]) {
+            n = find_empties(block + done, len - done, hits, MAXHITS);
+            if (n == 0)
+                break;
+            for (i = 0; i < n; i++)
+                put_line(block + done + hits[i], block + len);
             rv = 1;
+            if (n < MAXHITS)
+                break;
+            /* hits is full: carry on after the last line reported */
+            nl = memchr(block + done + hits[n - 1], '\n', len - done - hits[n - 1]);
+            hits[n - 1] = nl != NULL ? (size_t) (nl + 1 - (block + done)) : len - done;
         }
+
+    if (lr.error)
+        rv = 2;
+    lr_free(&lr);
     return rv;
 }
 
-int has_empty(char string[])
+void put_line(const char *line, const char *end)
+/*
+ *	prints the line starting at `line' followed by a newline, like puts
+ */
+{
+    const char *nl = memchr(line, '\n', end - line);
+
+    fwrite(line, 1, (nl != NULL ? nl : end) - line, stdout);
+    putchar('\n');
+}
+
+size_t empties_chunk(const char *in, size_t len, char *out, void *unused)
+/*
+ *	par_fn for -j: copies the lines of `in' that have empty fields
+ *	to `out', each ending in a newline; returns the bytes copied
+ */
+{
+    size_t hits[MAXHITS];
+    size_t n, i, done, used = 0;
+    const char *line, *nl;
+
+    (void) unused;
+    for (done = 0; done < len; done = nl != NULL ? (size_t) (nl + 1 - in) : len) {
+        n = find_empties(in + done, len - done, hits, MAXHITS);
+        for (i = 0; i < n; i++) {
+            line = in + done + hits[i];
+            nl = memchr(line, '\n', in + len - line);
+            memcpy(out + used, line, (nl != NULL ? nl : in + len) - line);
+            used += (nl != NULL ? nl : in + len) - line;
+            out[used++] = '\n';
+        }
+        if (n < MAXHITS)
+            break;
+    }
+    return used;
+}
+
+static void chunk_masks(const char *p, size_t n, uint64_t *eq, uint64_t *end, uint64_t *nl)
 /*
- *	looks through the string to see if any fields are empty.
- *	this means that the character after an = is a colon or a newline
- *	return TRUE if any empties are found, else returns FALSE
+ *	bit i of *eq, *end and *nl is set when p[i] is an '=', an end of
+ *	field (DELIM or newline) and a newline, for i < n <= CHUNK
  */
 {
-    int i;        /* use this for indexing */
+    size_t i;
+
+#ifdef __SSE2__
+    if (n == CHUNK) {
+        const __m128i equal = _mm_set1_epi8('=');
+        const __m128i delim = _mm_set1_epi8(DELIM);
+        const __m128i newline = _mm_set1_epi8('\n');
 
-    for (i = 0; string[i] != '\0'; i++)
-        if (string[i] == '=' && (string[i + 1] == DELIM || string[i + 1] == '\0'))
-            return TRUE;
-    return FALSE;
+        *eq = *end = *nl = 0;
+        for (i = 0; i < CHUNK; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+            __m128i is_nl = _mm_cmpeq_epi8(v, newline);
+            uint64_t m_eq = (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, equal));
+            uint64_t m_nl = (uint16_t) _mm_movemask_epi8(is_nl);
+            uint64_t m_end = (uint16_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, delim), is_nl));
+            *eq |= m_eq << i;
+            *nl |= m_nl << i;
+            *end |= m_end << i;
+        }
+        return;
+    }
+#endif
+    *eq = *end = *nl = 0;
+    for (i = 0; i < n; i++) {
+        *eq |= (uint64_t) (p[i] == '=') << i;
+        *nl |= (uint64_t) (p[i] == '\n') << i;
+        *end |= (uint64_t) (p[i] == DELIM || p[i] == '\n') << i;
+    }
 }
 
+size_t find_empties(const char *buf, size_t len, size_t offsets[], size_t max)
+/*
+ *	looks through a buffer of newline separated lines for empty fields,
+ *	an = followed by DELIM, a newline or the end of the buffer.
+ *	CHUNK bytes at a time it builds bitmasks of the = and end positions
+ *	and ANDs the = mask, shifted up by one, with the end mask; the top =
+ *	bit is carried into the next chunk so pairs that straddle a chunk
+ *	boundary are not lost.
+ *	stores the offset of each line with an empty field in `offsets', in
+ *	order and at most once per line; returns how many were stored (at
+ *	most `max')
+ */
+{
+    size_t found = 0;
+    size_t line = 0;            /* offset of the current line   */
+    size_t last = (size_t) -1;  /* last line reported           */
+    uint64_t carry = 0;         /* previous chunk ended in '='  */
+    uint64_t eq, end, nl, hits, below;
+    size_t i, n, j, start;
+
+    for (i = 0; i < len && found < max; i += n) {
+        n = len - i < CHUNK ? len - i : CHUNK;
+        chunk_masks(buf + i, n, &eq, &end, &nl);
+
+        hits = ((eq << 1) | carry) & end;
+        carry = (eq >> (n - 1)) & 1;
+
+        while (hits != 0 && found < max) {
+            j = __builtin_ctzll(hits);
+            hits &= hits - 1;
+
+            /* the '=' is at j - 1, so its line starts after the last newline before j */
+            below = j == 0 ? 0 : nl & (~(uint64_t) 0 >> (64 - j));
+            start = below != 0 ? i + (63 - __builtin_clzll(below)) + 1 : line;
+            if (start != last)
+                offsets[found++] = last = start;
+        }
+        if (nl != 0)
+            line = i + (63 - __builtin_clzll(nl)) + 1;
+    }
+
+    /* an '=' as the very last byte is an empty field too */
+    if (carry && found < max && line != last && len > 0)
+        offsets[found++] = line;
+    return found;
+}
@@ -0,0 +1,106 @@
+#define    _GNU_SOURCE
+#include    <errno.h>
+#include    <stdlib.h>
+#include    <sys/mman.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+#include    "input.h"
+
+/*
+ * input.c
+ *   purpose: mapped or block-read input, see input.h
+ */
+
+int in_map(struct input *in, int fd)
+/*
+ * purpose: map `fd' if it is a non-empty regular file that has not been
+ *          read from yet
+ * returns: 0 if it is mapped, -1 if it can not be; `in' is then unusable
+ *          until in_open
+ *   notes: a descriptor whose offset is not 0, as in (head -c 10; tool)
+ *          < file, is left to be read, so the tool starts where it should
+ */
+{
+    struct stat st;
+    void *base;
+
+    in->fd = fd;
+    in->base = NULL;
+    in->size = in->off = 0;
+    in->buf = NULL;
+    in->eof = in->error = 0;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+        || lseek(fd, 0, SEEK_CUR) != 0)
+        return -1;
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+        return -1;
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (st.st_size >= IN_HUGE_SIZE)
+        madvise(base, st.st_size, MADV_HUGEPAGE);
+#endif
+
+    in->base = base;
+    in->size = st.st_size;
+    return 0;
+}
+
+int in_open(struct input *in, int fd)
+/*
+ * purpose: set up `in' to hand out the bytes of `fd', mapped if possible
+ * returns: 0 on success, -1 if the read buffer can not be allocated
+ */
+{
+    if (in_map(in, fd) == 0)
+        return 0;
+    in->buf = malloc(IN_BLOCK_SIZE);
+    return in->buf == NULL ? -1 : 0;
+}
+
+int in_next(struct input *in, const char **p, size_t *len)
+/*
+ * purpose: hand out the next stretch of input: all of the mapping that is
+ *          left, or whatever one read returns
+ * returns: 1 with the view in *p, *len; 0 at end of input or on error
+ */
+{
+    ssize_t n;
+
+    if (in->eof || in->error)
+        return 0;
+    if (in->base != NULL) {
+        *p = in->base + in->off;
+        *len = in->size - in->off;
+        in->off = in->size;
+        in->eof = 1;
+        return *len > 0;
+    }
+
+    do
+        n = read(in->fd, in->buf, IN_BLOCK_SIZE);
+    while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        in->error = n < 0;
+        in->eof = 1;
+        return 0;
+    }
+    *p = in->buf;
+    *len = n;
+    return 1;
+}
+
+void in_close(struct input *in)
+/*
+ * purpose: release the mapping or the read buffer
+ */
+{
+    if (in->base != NULL)
+        munmap((void *) in->base, in->size);
+    free(in->buf);
+    in->base = NULL;
+    in->buf = NULL;
+    in->size = in->off = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include    <stddef.h>
+
+/*
+ * input.h
+ *   purpose: let the filters and converters get at their input without
+ *            stdio: a regular file is mapped and scanned in place, anything
+ *            else is read in large blocks
+ *     usage: in_open(&in, 0), then while (in_next(&in, &p, &len)) ...,
+ *            then in_close(&in). Tools that only want a mapping call
+ *            in_map, which leaves the descriptor alone if it returns -1.
+ *            Only a file read from its start is mapped; one that has been
+ *            read from already is read from where it is.
+ *     notes: a mapping is handed out by in_next as one view of the whole
+ *            file. It is advised MADV_SEQUENTIAL so the kernel reads well
+ *            ahead, and MADV_HUGEPAGE once it is IN_HUGE_SIZE or more, a
+ *            hint the kernel may ignore for file pages. Views into the
+ *            read buffer are only good until the next call.
+ *            Shared by the Assignment-1 and Assignment-2 builds.
+ */
+
+#define    IN_BLOCK_SIZE    (1 << 17)
+#define    IN_HUGE_SIZE     (2 << 20)
+
+struct input {
+    int fd;                 /* descriptor being read                */
+    const char *base;       /* read-only mapping of the whole file, or NULL */
+    size_t size;            /* its length                           */
+    size_t off;             /* first mapped byte not handed out yet */
+    char *buf;              /* read buffer when the input is not mapped */
+    int eof;                /* 1 once everything has been handed out */
+    int error;              /* 1 if a read failed                   */
+};
+
+int in_map(struct input *, int);
+
+int in_open(struct input *, int);
+
+int in_next(struct input *, const char **, size_t *);
+
+void in_close(struct input *);
+
+#endif
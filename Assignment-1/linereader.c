@@ -0,0 +1,150 @@
+#define    _GNU_SOURCE
+#include    <errno.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <unistd.h>
+#include    "linereader.h"
+
+/*
+ * linereader.c
+ *   purpose: growable arena line reader, see linereader.h
+ */
+
+static int fill(struct line_reader *);
+
+int lr_init(struct line_reader *lr, int fd)
+/*
+ * purpose: set up `lr' to read from `fd'
+ * returns: 0 on success, -1 if the arena can not be allocated
+ */
+{
+    lr->fd = fd;
+    lr->start = 0;
+    lr->error = 0;
+    if (in_map(&lr->in, fd) == 0) {
+        /* the whole file is already "read"; fill is never called */
+        lr->buf = (char *) lr->in.base;
+        lr->cap = lr->end = lr->in.size;
+        lr->eof = 1;
+        return 0;
+    }
+
+    lr->cap = LR_INITIAL_SIZE;
+    lr->buf = malloc(lr->cap);
+    lr->start = lr->end = 0;
+    lr->eof = 0;
+    lr->error = lr->buf == NULL;
+    return lr->buf == NULL ? -1 : 0;
+}
+
+int lr_line(struct line_reader *lr, const char **line, size_t *len)
+/*
+ * purpose: hand out the next line
+ * returns: 1 with the view in *line, *len; 0 at end of input or on error
+ */
+{
+    char *nl;
+    size_t scanned = 0;     /* bytes already known to hold no newline */
+
+    for (;;) {
+        nl = memchr(lr->buf + lr->start + scanned, '\n', lr->end - lr->start - scanned);
+        if (nl != NULL) {
+            *line = lr->buf + lr->start;
+            *len = nl + 1 - *line;
+            lr->start += *len;
+            return 1;
+        }
+        scanned = lr->end - lr->start;
+        if (lr->eof || fill(lr) <= 0) {
+            if (lr->start == lr->end)
+                return 0;
+            *line = lr->buf + lr->start;    /* last line, no newline */
+            *len = lr->end - lr->start;
+            lr->start = lr->end;
+            return 1;
+        }
+    }
+}
+
+int lr_block(struct line_reader *lr, const char **block, size_t *len)
+/*
+ * purpose: hand out every complete line currently buffered, reading
+ *          more first if there is not at least one
+ * returns: 1 with the view in *block, *len; 0 at end of input or on error
+ */
+{
+    char *nl;
+
+    if (lr->start == lr->end && !lr->eof)
+        fill(lr);
+    for (;;) {
+        nl = lr->end > lr->start ? memrchr(lr->buf + lr->start, '\n', lr->end - lr->start) : NULL;
+        if (nl != NULL) {
+            *block = lr->buf + lr->start;
+            *len = nl + 1 - *block;
+            lr->start += *len;
+            return 1;
+        }
+        if (lr->eof || fill(lr) <= 0) {
+            if (lr->start == lr->end)
+                return 0;
+            *block = lr->buf + lr->start;
+            *len = lr->end - lr->start;
+            lr->start = lr->end;
+            return 1;
+        }
+    }
+}
+
+static int fill(struct line_reader *lr)
+/*
+ * purpose: move the unread bytes to the front of the arena, growing it
+ *          if they fill it, and read as much as fits behind them
+ * returns: 1 if anything was read, 0 at end of input, -1 on error
+ */
+{
+    size_t keep = lr->end - lr->start;
+    ssize_t n;
+    char *bigger;
+
+    if (lr->start > 0) {
+        memmove(lr->buf, lr->buf + lr->start, keep);
+        lr->start = 0;
+        lr->end = keep;
+    }
+    if (keep == lr->cap) {
+        bigger = realloc(lr->buf, lr->cap * 2);
+        if (bigger == NULL) {
+            lr->error = 1;
+            return -1;
+        }
+        lr->buf = bigger;
+        lr->cap *= 2;
+    }
+
+    do
+        n = read(lr->fd, lr->buf + lr->end, lr->cap - lr->end);
+    while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        lr->error = 1;
+        return -1;
+    }
+    if (n == 0)
+        lr->eof = 1;
+    lr->end += n;
+    return (int) (n > 0);
+}
+
+void lr_free(struct line_reader *lr)
+/*
+ * purpose: release the arena, or the mapping
+ */
+{
+    if (lr->in.base != NULL)
+        in_close(&lr->in);
+    else
+        free(lr->buf);
+    lr->buf = NULL;
+    lr->cap = lr->start = lr->end = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef LINEREADER_H
+#define LINEREADER_H
+
+#include    <stddef.h>
+#include    "input.h"
+
+/*
+ * linereader.h
+ *   purpose: read newline separated lines of any length from a descriptor
+ *            without a malloc per line
+ *     usage: lr_init(&lr, 0) then either
+ *              lr_line(&lr, &p, &len)   one line at a time, or
+ *              lr_block(&lr, &p, &len)  every complete line buffered so far
+ *            until they return 0; lr_free(&lr) at the end.
+ *     notes: when the descriptor is a regular file it is mapped (see
+ *            input.h) and the views point straight into the mapping.
+ *            Otherwise they point into one reusable arena that is refilled
+ *            with large reads and doubled whenever a single line outgrows
+ *            it, so a view is only good until the next call. Views include
+ *            the newline, except for a last line that has none.
+ */
+
+#define    LR_INITIAL_SIZE    (1 << 16)
+
+struct line_reader {
+    int fd;             /* descriptor being read                */
+    char *buf;          /* the arena                            */
+    size_t cap;         /* its size                             */
+    size_t start;       /* first byte not yet handed out        */
+    size_t end;         /* one past the last byte read          */
+    int eof;            /* 1 once read returned 0               */
+    int error;          /* 1 if a read or allocation failed     */
+    struct input in;    /* the mapping, if the input is mapped  */
+};
+
+int lr_init(struct line_reader *, int);
+
+int lr_line(struct line_reader *, const char **, size_t *);
+
+int lr_block(struct line_reader *, const char **, size_t *);
+
+void lr_free(struct line_reader *);
+
+#endif
@@ -0,0 +1,331 @@
+#define    _GNU_SOURCE
+#include    <errno.h>
+#include    <pthread.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <unistd.h>
+#include    "input.h"
+#include    "parallel.h"
+
+/*
+ * parallel.c
+ *   purpose: chunked, ordered, multi-threaded filter driver, see parallel.h
+ *     notes: `jobs' workers are started once per par_filter call and take
+ *            chunks from a ring of two slots per worker. Chunk k lives in
+ *            slot k % slots. The main thread reads (or, on a mapping, just
+ *            cuts) chunks into free slots, and writes the oldest chunk out
+ *            as soon as it is filtered, which frees its slot for the next
+ *            read. So reading, filtering and writing overlap, and a slow
+ *            chunk only holds up the writing, not the other workers.
+ */
+
+#define    MAX_JOBS    256
+
+struct chunk {
+    const char *in;         /* the lines to filter                  */
+    size_t len;
+    char *own;              /* input buffer when not mapped         */
+    size_t own_cap;
+    size_t own_len;         /* bytes in `own', including a carried tail */
+    char *out;              /* output buffer                        */
+    size_t out_cap;
+    size_t out_len;
+    int done;               /* filtered, waiting to be written      */
+};
+
+struct ring {
+    struct chunk *chunks;   /* `slots' of them, plus an empty one   */
+    int slots;
+    long filled;            /* chunks handed to the workers so far  */
+    long taken;             /* chunks a worker has started on       */
+    int quit;               /* no more chunks are coming            */
+    int failed;             /* a worker could not get memory        */
+    size_t ratio;
+    par_fn fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t work;    /* filled went up, or quit was set      */
+    pthread_cond_t done;    /* a chunk was filtered                 */
+};
+
+static void *worker(void *);
+
+static void filter_chunk(struct ring *, struct chunk *);
+
+static int read_chunk(int, struct chunk *, struct chunk *, int *);
+
+static int write_chunk(int, const struct chunk *);
+
+static int grow(char **, size_t *, size_t);
+
+int par_take_jobs(int *argc, char *argv[])
+/*
+ * purpose: find "-j N" or "-jN" among the arguments and remove it
+ * returns: N, clamped to 1..MAX_JOBS; 1 if there is no -j
+ */
+{
+    int i, j, n, used, jobs = 1;
+
+    for (i = 1; i < *argc; i++) {
+        if (strncmp(argv[i], "-j", 2) != 0)
+            continue;
+        if (argv[i][2] != '\0') {
+            n = atoi(argv[i] + 2);
+            used = 1;
+        } else if (i + 1 < *argc) {
+            n = atoi(argv[i + 1]);
+            used = 2;
+        } else {
+            n = 1;
+            used = 1;
+        }
+        jobs = n < 1 ? 1 : n > MAX_JOBS ? MAX_JOBS : n;
+        for (j = i; j + used <= *argc; j++)
+            argv[j] = argv[j + used];
+        *argc -= used;
+        break;
+    }
+    return jobs;
+}
+
+int par_filter(int in, int out, int jobs, size_t ratio, par_fn fn, void *arg)
+/*
+ * purpose: filter `in' to `out' with `jobs' threads
+ * returns: 1 if anything was written, 0 if the output is empty,
+ *          -1 on a read, write or allocation error
+ */
+{
+    struct input src;
+    struct ring r;
+    pthread_t threads[MAX_JOBS];
+    const char *base = NULL, *nl;
+    size_t size = 0, off = 0, len;
+    long written = 0;
+    int i, started, eof = 0, wrote = 0, rv = 0;
+
+    r.slots = 2 * jobs;
+    r.chunks = calloc(r.slots + 1, sizeof(struct chunk));
+    if (r.chunks == NULL)
+        return -1;
+    r.filled = r.taken = 0;
+    r.quit = r.failed = 0;
+    r.ratio = ratio;
+    r.fn = fn;
+    r.arg = arg;
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.work, NULL);
+    pthread_cond_init(&r.done, NULL);
+
+    if (in_map(&src, in) == 0) {
+        base = src.base;
+        size = src.size;
+    }
+
+    for (started = 0; started < jobs; started++)
+        if (pthread_create(&threads[started], NULL, worker, &r) != 0)
+            break;
+
+    while (rv == 0) {
+        struct chunk *c;
+
+        /* fill every free slot; the chunk before the first is the empty spare */
+        while (!eof && r.filled - written < r.slots) {
+            c = &r.chunks[r.filled % r.slots];
+            if (base != NULL) {
+                len = size - off < PAR_CHUNK ? size - off : PAR_CHUNK;
+                nl = memchr(base + off + len, '\n', size - off - len);
+                len = nl == NULL ? size - off : (size_t) (nl + 1 - (base + off));
+                c->in = base + off;
+                c->len = len;
+                off += len;
+                eof = off == size;
+            } else {
+                struct chunk *prev = r.filled > 0 ? &r.chunks[(r.filled - 1) % r.slots] : &r.chunks[r.slots];
+                if (read_chunk(in, c, prev, &eof) != 0) {
+                    rv = -1;
+                    break;
+                }
+                if (c->len == 0 && eof)
+                    break;
+            }
+            pthread_mutex_lock(&r.lock);
+            r.filled++;
+            pthread_cond_signal(&r.work);
+            pthread_mutex_unlock(&r.lock);
+        }
+        if (rv != 0 || written == r.filled)
+            break;
+
+        /* write the oldest chunk once it is filtered */
+        c = &r.chunks[written % r.slots];
+        if (started == 0) {
+            /* no thread could be started: filter it here */
+            r.taken++;
+            filter_chunk(&r, c);
+        }
+        pthread_mutex_lock(&r.lock);
+        while (!c->done)
+            pthread_cond_wait(&r.done, &r.lock);
+        c->done = 0;
+        if (r.failed)
+            rv = -1;
+        pthread_mutex_unlock(&r.lock);
+        if (rv != 0)
+            break;
+        wrote |= c->out_len > 0;
+        if (write_chunk(out, c) != 0)
+            rv = -1;
+        written++;
+    }
+
+    pthread_mutex_lock(&r.lock);
+    r.quit = 1;
+    pthread_cond_broadcast(&r.work);
+    pthread_mutex_unlock(&r.lock);
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    for (i = 0; i <= r.slots; i++) {
+        free(r.chunks[i].own);
+        free(r.chunks[i].out);
+    }
+    free(r.chunks);
+    pthread_cond_destroy(&r.done);
+    pthread_cond_destroy(&r.work);
+    pthread_mutex_destroy(&r.lock);
+    if (base != NULL)
+        in_close(&src);
+    return rv != 0 ? -1 : wrote;
+}
+
+static void *worker(void *p)
+/*
+ * purpose: filter chunks as they are filled until told to quit
+ */
+{
+    struct ring *r = p;
+    struct chunk *c;
+
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        while (!r->quit && r->taken == r->filled)
+            pthread_cond_wait(&r->work, &r->lock);
+        if (r->quit)
+            break;
+        c = &r->chunks[r->taken++ % r->slots];
+        pthread_mutex_unlock(&r->lock);
+        filter_chunk(r, c);
+        pthread_mutex_lock(&r->lock);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+static void filter_chunk(struct ring *r, struct chunk *c)
+/*
+ * purpose: run the filter over one chunk and mark it done
+ */
+{
+    int failed = 0;
+
+    c->out_len = 0;
+    if (grow(&c->out, &c->out_cap, r->ratio * c->len + PAR_SLACK) != 0)
+        failed = 1;
+    else
+        c->out_len = r->fn(c->in, c->len, c->out, r->arg);
+
+    pthread_mutex_lock(&r->lock);
+    r->failed |= failed;
+    c->done = 1;
+    pthread_cond_broadcast(&r->done);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static int read_chunk(int in, struct chunk *c, struct chunk *prev, int *eof)
+/*
+ * purpose: fill `c' with the tail `prev' left over plus about PAR_CHUNK
+ *          more bytes, up to the last newline; at end of input, with
+ *          everything that is left
+ * returns: 0 on success, -1 on a read or allocation error
+ */
+{
+    size_t tail = prev->own_len - prev->len;
+    ssize_t n;
+    char *nl;
+
+    if (prev->own == NULL)
+        tail = 0;
+    if (grow(&c->own, &c->own_cap, tail + PAR_CHUNK) != 0)
+        return -1;
+    if (tail > 0)
+        memcpy(c->own, prev->own + prev->len, tail);
+    c->own_len = tail;
+
+    for (;;) {
+        while (c->own_len < c->own_cap) {
+            n = read(in, c->own + c->own_len, c->own_cap - c->own_len);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return -1;
+            if (n == 0) {
+                *eof = 1;
+                break;
+            }
+            c->own_len += n;
+        }
+        c->in = c->own;
+        if (*eof) {
+            c->len = c->own_len;
+            return 0;
+        }
+        nl = memrchr(c->own, '\n', c->own_len);
+        if (nl != NULL) {
+            c->len = nl + 1 - c->own;
+            return 0;
+        }
+        /* a single line longer than the buffer */
+        if (grow(&c->own, &c->own_cap, c->own_cap * 2) != 0)
+            return -1;
+    }
+}
+
+static int write_chunk(int fd, const struct chunk *c)
+/*
+ * purpose: write the output of one chunk, continuing after short writes
+ * returns: 0 on success, -1 on error
+ */
+{
+    const char *p = c->out;
+    size_t left = c->out_len;
+    ssize_t n;
+
+    while (left > 0) {
+        n = write(fd, p, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        p += n;
+        left -= n;
+    }
+    return 0;
+}
+
+static int grow(char **buf, size_t *cap, size_t want)
+/*
+ * purpose: make sure *buf has room for `want' bytes, keeping its contents
+ * returns: 0 on success, -1 if memory runs out
+ */
+{
+    char *bigger;
+
+    if (*cap >= want)
+        return 0;
+    bigger = realloc(*buf, want);
+    if (bigger == NULL)
+        return -1;
+    *buf = bigger;
+    *cap = want;
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include    <stddef.h>
+
+/*
+ * parallel.h
+ *   purpose: run a line filter over its input on several threads
+ *     usage: jobs = par_take_jobs(&argc, argv) removes a "-j N" option from
+ *            the arguments. With jobs > 1 the tool calls
+ *              par_filter(0, 1, jobs, ratio, fn, arg)
+ *            which splits the input into chunks of about PAR_CHUNK bytes
+ *            that end on a newline, runs fn(in, len, out, arg) on each chunk
+ *            on a pool of `jobs' threads and writes the outputs back in the
+ *            input order. `out' has room for ratio * len + PAR_SLACK bytes;
+ *            fn returns how many it used.
+ *     notes: a regular file is mapped and chunked in place, anything else is
+ *            read into per-chunk buffers. fn must only depend on the lines
+ *            it is given, since each chunk starts a fresh line, and must be
+ *            safe to call from several threads at once.
+ */
+
+#define    PAR_CHUNK    (4 << 20)
+#define    PAR_SLACK    64
+
+typedef size_t (*par_fn)(const char *, size_t, char *, void *);
+
+int par_take_jobs(int *, char *[]);
+
+int par_filter(int, int, int, size_t, par_fn, void *);
+
+#endif
@@ -0,0 +1,134 @@
+#define    _GNU_SOURCE
+#include    <errno.h>
+#include    <fcntl.h>
+#include    <sys/mman.h>
+#include    <sys/sendfile.h>
+#include    <sys/stat.h>
+#include    <sys/uio.h>
+#include    <unistd.h>
+#include    "input.h"
+#include    "passthru.h"
+
+/*
+ * passthru.c
+ *   purpose: zero-copy output of unchanged input spans, see passthru.h
+ */
+
+static int kernel_copy(struct passthru *, size_t *, size_t *);
+
+int passthru_open(struct passthru *pt, int in, int out)
+/*
+ * purpose: map `in' and work out how spans can reach `out'
+ * returns: 0 on success, -1 if `in' is not a non-empty regular file or can
+ *          not be mapped; the caller should then use its ordinary path
+ */
+{
+    struct stat st;
+    struct input src;
+
+    if (in_map(&src, in) != 0)
+        return -1;
+
+    pt->in = in;
+    pt->out = out;
+    pt->base = (const unsigned char *) src.base;
+    pt->size = src.size;
+    pt->out_kind = PT_OTHER;
+    if (fstat(out, &st) == 0) {
+        if (S_ISFIFO(st.st_mode))
+            pt->out_kind = PT_PIPE;
+        else if (S_ISREG(st.st_mode))
+            pt->out_kind = PT_FILE;
+    }
+    return 0;
+}
+
+int passthru_span(struct passthru *pt, size_t off, size_t len)
+/*
+ * purpose: send input bytes [off, off + len) to the output unchanged
+ * returns: 0 on success, -1 on a write error
+ */
+{
+    if (kernel_copy(pt, &off, &len) == 0)
+        return 0;
+    return passthru_write(pt->out, pt->base + off, len);
+}
+
+static int kernel_copy(struct passthru *pt, size_t *offp, size_t *lenp)
+/*
+ * purpose: move the span without a user space copy
+ * returns: 0 when all of it went out, -1 to fall back to write
+ *   notes: *offp and *lenp are advanced past whatever did go out, so
+ *          the fallback only writes what is left
+ */
+{
+    struct iovec iov;
+    loff_t in_off;
+    ssize_t n;
+    size_t off = *offp, len = *lenp;
+
+    while (len > 0) {
+        switch (pt->out_kind) {
+            case PT_PIPE:
+                /* the mapping is read-only file pages, safe to lend out */
+                iov.iov_base = (void *) (pt->base + off);
+                iov.iov_len = len;
+                n = vmsplice(pt->out, &iov, 1, 0);
+                break;
+            case PT_FILE:
+                in_off = off;
+                n = copy_file_range(pt->in, &in_off, pt->out, NULL, len, 0);
+                break;
+            default:
+                in_off = off;
+                n = sendfile(pt->out, pt->in, &in_off, len);
+                break;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            if (pt->out_kind == PT_FILE) {
+                pt->out_kind = PT_OTHER;    /* e.g. EXDEV, try sendfile */
+                continue;
+            }
+            *offp = off;
+            *lenp = len;
+            return -1;
+        }
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int passthru_write(int fd, const void *buf, size_t len)
+/*
+ * purpose: write all of `buf', retrying short writes and EINTR
+ * returns: 0 on success, -1 on error
+ */
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void passthru_close(struct passthru *pt)
+/*
+ * purpose: release the input mapping
+ */
+{
+    munmap((void *) pt->base, pt->size);
+    pt->base = NULL;
+    pt->size = 0;
+}
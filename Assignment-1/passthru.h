@@ -0,0 +1,41 @@
+#ifndef PASSTHRU_H
+#define PASSTHRU_H
+
+#include    <stddef.h>
+#include    <sys/types.h>
+
+/*
+ * passthru.h
+ *   purpose: let a filter hand unchanged stretches of its input to the
+ *            kernel instead of copying them through user space
+ *     usage: passthru_open(&pt, 0, 1) maps stdin when it is a regular file;
+ *            the filter scans pt.base[0..pt.size) in place, writes the bytes
+ *            it rewrites itself and calls passthru_span() for the stretches
+ *            in between. Spans go out with vmsplice when stdout is a pipe,
+ *            copy_file_range when it is a regular file and sendfile otherwise,
+ *            falling back to write when the kernel refuses.
+ *     notes: Linux only. Only worth it for spans of PASSTHRU_MIN bytes or more;
+ *            shorter ones are cheaper to copy into the filter's own buffer.
+ */
+
+#define    PASSTHRU_MIN    (1 << 16)
+
+struct passthru {
+    int in;                     /* input descriptor, a regular file     */
+    int out;                    /* output descriptor                    */
+    int out_kind;               /* PT_PIPE, PT_FILE or PT_OTHER         */
+    const unsigned char *base;  /* read-only mapping of the whole input */
+    size_t size;                /* length of the mapping                */
+};
+
+enum { PT_PIPE, PT_FILE, PT_OTHER };
+
+int passthru_open(struct passthru *, int, int);
+
+int passthru_span(struct passthru *, size_t, size_t);
+
+int passthru_write(int, const void *, size_t);
+
+void passthru_close(struct passthru *);
+
+#endif
@@ -0,0 +1,215 @@
+#include    <string.h>
+#include    "record.h"
+
+#ifdef __SSE2__
+#include    <emmintrin.h>
+#endif
+
+/*
+ * record.c
+ *   purpose: zero-copy tokenizer for KEY=value;KEY=value records,
+ *            see record.h
+ */
+
+static void add_delim(struct record *, size_t, char, size_t *, long *);
+
+static void end_field(struct record *, size_t, size_t, long);
+
+static uint32_t key_hash(uint32_t, const char *, size_t);
+
+#define    KEY_SEEDS    4096    /* seeds record_keyset tries before it gives up */
+
+int record_parse(struct record *rec, const char *line, size_t len)
+/*
+ * purpose: split `line' into fields
+ * returns: the number of fields stored, or -1 if not all of them could
+ *          be, see record.h
+ *   notes: a trailing "\n" or "\r\n" is not part of the record
+ */
+{
+    size_t i = 0;
+    size_t start = 0;       /* offset of the current field      */
+    long eq = -1;           /* its first '=', -1 if none yet    */
+
+    if (len > 0 && line[len - 1] == '\n')
+        len--;
+    if (len > 0 && line[len - 1] == '\r')
+        len--;
+
+    rec->line = line;
+    rec->len = len;
+    rec->nfields = 0;
+    rec->truncated = 0;
+    rec->rest = 0;
+    if (len >= RECORD_MAX_LEN) {
+        rec->truncated = 1;
+        return -1;
+    }
+
+#ifdef __SSE2__
+    {
+        const __m128i semi = _mm_set1_epi8(RECORD_DELIM);
+        const __m128i equal = _mm_set1_epi8(RECORD_KEY_DELIM);
+
+        /* one mask of delimiter positions per 16 bytes */
+        for (; i + 16 <= len && !rec->truncated; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (line + i));
+            unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, semi),
+                                                           _mm_cmpeq_epi8(v, equal)));
+            while (mask != 0) {
+                size_t at = i + __builtin_ctz(mask);
+                add_delim(rec, at, line[at], &start, &eq);
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+    for (; i < len && !rec->truncated; i++)
+        if (line[i] == RECORD_DELIM || line[i] == RECORD_KEY_DELIM)
+            add_delim(rec, i, line[i], &start, &eq);
+
+    if (len > 0 && !rec->truncated)
+        end_field(rec, start, len, eq);
+    return rec->truncated ? -1 : rec->nfields;
+}
+
+static void add_delim(struct record *rec, size_t at, char c, size_t *start, long *eq)
+/*
+ * purpose: account for one delimiter at offset `at'
+ */
+{
+    if (c == RECORD_KEY_DELIM) {
+        if (*eq < 0)
+            *eq = (long) at;
+        return;
+    }
+    end_field(rec, *start, at, *eq);
+    *start = at + 1;
+    *eq = -1;
+}
+
+static void end_field(struct record *rec, size_t start, size_t end, long eq)
+/*
+ * purpose: store the field [start, end) whose first '=' is at `eq'
+ */
+{
+    struct field_span *f;
+
+    if (rec->nfields == RECORD_MAX_FIELDS) {
+        if (!rec->truncated)
+            rec->rest = start;
+        rec->truncated = 1;
+        return;
+    }
+    f = &rec->fields[rec->nfields++];
+    f->key_off = (uint32_t) start;
+    if (eq < 0) {
+        f->key_len = 0;
+        f->val_off = (uint32_t) start;
+    } else {
+        f->key_len = (uint32_t) (eq - start);
+        f->val_off = (uint32_t) (eq + 1);
+    }
+    f->val_len = (uint32_t) (end - f->val_off);
+}
+
+size_t record_scan(const char *buf, size_t len,
+                   int (*fn)(const struct record *, void *), void *arg)
+/*
+ * purpose: parse every complete line in `buf' and pass it to `fn'
+ * returns: the number of bytes consumed; stops early after the line
+ *          for which `fn' returns non-zero
+ *   notes: a final line with no newline is left for the caller, who can
+ *          prepend it to the next buffer or record_parse it at end of input
+ */
+{
+    struct record rec;
+    const char *p = buf, *end = buf + len, *nl;
+
+    while (p < end && (nl = memchr(p, '\n', end - p)) != NULL) {
+        record_parse(&rec, p, nl - p + 1);
+        p = nl + 1;
+        if (fn(&rec, arg) != 0)
+            break;
+    }
+    return p - buf;
+}
+
+int record_keyset(struct record_keyset *ks, const char *list)
+/*
+ * purpose: compile the comma separated keys in `list' for
+ *          record_key_index; a key may be listed more than once
+ * returns: 0, or -1 if a key is empty, there are more than
+ *          RECORD_MAX_KEYS of them or no seed hashes them apart
+ *   notes: the keys point into `list', which must stay alive
+ */
+{
+    const char *p = list, *comma;
+    uint32_t seed;
+    int i, k;
+
+    ks->nkeys = ks->ncols = 0;
+    for (;;) {
+        size_t len;
+
+        comma = strchr(p, ',');
+        len = comma != NULL ? (size_t) (comma - p) : strlen(p);
+        if (len == 0 || ks->ncols == RECORD_MAX_KEYS)
+            return -1;
+        for (k = 0; k < ks->nkeys; k++)
+            if (ks->lens[k] == len && memcmp(ks->names[k], p, len) == 0)
+                break;
+        if (k == ks->nkeys) {
+            ks->names[k] = p;
+            ks->lens[k] = len;
+            ks->nkeys++;
+        }
+        ks->cols[ks->ncols++] = k;
+        if (comma == NULL)
+            break;
+        p = comma + 1;
+    }
+
+    /* FNV-1a from different starting points until every key has a slot of its own */
+    for (seed = 2166136261u; seed < 2166136261u + KEY_SEEDS; seed++) {
+        memset(ks->slots, -1, sizeof(ks->slots));
+        for (i = 0; i < ks->nkeys; i++) {
+            uint32_t h = key_hash(seed, ks->names[i], ks->lens[i]);
+            if (ks->slots[h] >= 0)
+                break;
+            ks->slots[h] = (signed char) i;
+        }
+        if (i == ks->nkeys) {
+            ks->seed = seed;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int record_key_index(const struct record_keyset *ks, const char *key, size_t len)
+/*
+ * purpose: look `key' up in the set
+ * returns: its key index, the value of ks->cols for its columns,
+ *          or -1 if it is not in the set
+ */
+{
+    int k = ks->slots[key_hash(ks->seed, key, len)];
+
+    if (k < 0 || ks->lens[k] != len || memcmp(ks->names[k], key, len) != 0)
+        return -1;
+    return k;
+}
+
+static uint32_t key_hash(uint32_t seed, const char *key, size_t len)
+/*
+ * purpose: hash a key to a slot of the keyset table
+ */
+{
+    uint32_t h = seed;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        h = (h ^ (unsigned char) key[i]) * 16777619u;
+    return (h ^ h >> 16) & (RECORD_KEY_SLOTS - 1);
+}
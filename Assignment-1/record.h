@@ -0,0 +1,69 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include    <stddef.h>
+#include    <stdint.h>
+
+/*
+ * record.h
+ *   purpose: split schedule records of the form
+ *              TR=002;dir=i;day=m-f;TI=05:20;stn=bridgewater;Line=middleborough
+ *            into key and value spans without copying or allocating
+ *     usage: record_parse(&rec, line, len) fills rec.fields with offsets into
+ *            `line', which must stay alive while `rec' is used.
+ *            record_scan() runs a callback for every line of a buffer.
+ *            record_keyset(&ks, "TI,stn,Line") compiles a list of keys
+ *            into a perfect hash; record_key_index(&ks, key, len) then
+ *            says which of them a key is with one hash and one compare.
+ *     notes: the first '=' in a field ends its key, so values may contain '='.
+ *            A field without '=' has an empty key. A record with more than
+ *            RECORD_MAX_FIELDS fields makes record_parse return -1 with
+ *            rec.truncated set and the first RECORD_MAX_FIELDS stored; the
+ *            rest start at rec.rest, where the caller can parse them as a
+ *            record of their own. One of RECORD_MAX_LEN bytes or more has
+ *            offsets too large for a field_span: it also gives -1, with no
+ *            fields stored and rec.rest 0.
+ */
+
+#define    RECORD_MAX_FIELDS    32
+#define    RECORD_MAX_LEN       UINT32_MAX
+#define    RECORD_DELIM         ';'
+#define    RECORD_KEY_DELIM     '='
+#define    RECORD_MAX_KEYS      16
+#define    RECORD_KEY_SLOTS     64      /* a power of 2, the hash table size */
+
+struct field_span {
+    uint32_t key_off;
+    uint32_t key_len;
+    uint32_t val_off;
+    uint32_t val_len;
+};
+
+struct record {
+    const char *line;           /* start of the record              */
+    size_t len;                 /* length without the line end      */
+    int nfields;                /* fields stored in `fields'        */
+    int truncated;              /* 1 if fields were not stored      */
+    size_t rest;                /* offset of the first one not stored */
+    struct field_span fields[RECORD_MAX_FIELDS];
+};
+
+struct record_keyset {
+    int nkeys;                          /* distinct keys                */
+    int ncols;                          /* keys as listed, with repeats */
+    int cols[RECORD_MAX_KEYS];          /* key index of every column    */
+    const char *names[RECORD_MAX_KEYS]; /* the keys, in the list string */
+    size_t lens[RECORD_MAX_KEYS];
+    uint32_t seed;                      /* the hash that has no collisions */
+    signed char slots[RECORD_KEY_SLOTS];/* key index by hash, -1 if none */
+};
+
+int record_parse(struct record *, const char *, size_t);
+
+size_t record_scan(const char *, size_t, int (*)(const struct record *, void *), void *);
+
+int record_keyset(struct record_keyset *, const char *);
+
+int record_key_index(const struct record_keyset *, const char *, size_t);
+
+#endif
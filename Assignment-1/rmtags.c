@@ -1,45 +1,266 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include "input.h"
+#include "parallel.h"
+#include "passthru.h"
+#include "record.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /*
  * File: rmtags.c
  * Purpose: remove the tags
  * Author: Bhavani Shekhawat
+ * Usage: rmtags [-j N] [-k key,...] < input; -j strips the tags on N threads
+ *        -k  write only the values of the listed keys, in the listed order,
+ *            tab separated, one line per record; a key the record does not
+ *            have gives an empty column. Fields end at ';' or a tab, and
+ *            the first '=' of a field ends its key (see record.h)
  */
 
-int main() {
+#define BLOCK_SIZE (1 << 16)
+
+// Where the scan is in the current line
+struct tag_state {
+    int foundEqual;
+    int foundSemiColon;
+};
+
+// Where -k is in a chunk; the values are offsets into the chunk
+struct projection {
+    const struct record_keyset *ks;
+    size_t val[RECORD_MAX_KEYS];        // where the value of each key starts
+    size_t end[RECORD_MAX_KEYS];        // and ends
+    unsigned seen[RECORD_MAX_KEYS];     // the line each key was last found on
+    unsigned line;                      // lines are counted from 1, so 0 is never
+    size_t field;                       // start of the current field
+    size_t eq;                          // one past its first '=', 0 if it has none yet
+};
+
+size_t rmtags_chunk(const char *in, size_t len, char *out, void *unused);
+
+size_t rmtags_scan(const char *in, size_t len, char *out, struct tag_state *st);
+
+size_t project_chunk(const char *in, size_t len, char *out, void *arg);
+
+size_t project_event(struct projection *pj, const char *in, size_t at, char *out);
+
+void end_field(struct projection *pj, const char *in, size_t at);
+
+size_t end_line(struct projection *pj, const char *in, char *out);
+
+int main(int argc, char *argv[]) {
 
-    int c;
-    int foundEqual = false;
-    int foundSemiColon = false;
+    static char block[2 * BLOCK_SIZE];
+    struct tag_state st = {false, false};
+    struct input src;
+    const char *p;
+    size_t len;
+    int jobs = par_take_jobs(&argc, argv);
 
-    while ((c = getchar()) != EOF) {
+    // Every record is whole inside a chunk (see parallel.h), so -k takes that path even on one thread
+    if (argc > 1 && strcmp(argv[1], "-k") == 0) {
+        static struct record_keyset ks;
+
+        if (argc != 3 || record_keyset(&ks, argv[2]) != 0) {
+            fprintf(stderr, "usage: rmtags [-j N] [-k key,...] < input (at most %d keys)\n", RECORD_MAX_KEYS);
+            return 2;
+        }
+        return par_filter(0, 1, jobs, (size_t) ks.ncols, project_chunk, &ks) < 0;
+    }
+
+    // Every line starts with both flags clear, so chunks of lines can be done in parallel
+    if (jobs > 1) {
+        return par_filter(0, 1, jobs, 2, rmtags_chunk, NULL) < 0;
+    }
+
+    // The input is scanned in place (see input.h), BLOCK_SIZE bytes at a time
+    if (in_open(&src, 0) != 0) {
+        perror("rmtags");
+        return 1;
+    }
+    while (in_next(&src, &p, &len)) {
+        for (size_t done = 0; done < len; done += BLOCK_SIZE) {
+            size_t n = len - done < BLOCK_SIZE ? len - done : BLOCK_SIZE;
+
+            if (passthru_write(1, block, rmtags_scan(p + done, n, block, &st)) != 0) {
+                perror("rmtags: write");
+                return 1;
+            }
+        }
+    }
+    if (src.error) {
+        perror("rmtags: read");
+        return 1;
+    }
+    in_close(&src);
+
+    return 0;
+}
+
+/*
+ * The filter over a chunk of whole lines in memory. Writes at most two
+ * bytes per input byte to out and returns how many it wrote
+ */
+size_t rmtags_chunk(const char *in, size_t len, char *out, void *unused) {
+
+    struct tag_state st = {false, false};
+
+    (void) unused;
+    return rmtags_scan(in, len, out, &st);
+}
+
+/*
+ * Every byte becomes a NUL, and the value after each '=' up to the next
+ * ';' or tab is kept in front of its NULs. st carries the flags from one
+ * call to the next, so the input can be cut anywhere
+ */
+size_t rmtags_scan(const char *in, size_t len, char *out, struct tag_state *st) {
+
+    size_t used = 0;
+    int foundEqual = st->foundEqual;
+    int foundSemiColon = st->foundSemiColon;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = in[i];
 
         if (c == '=') {
-            putchar('\0');
+            out[used++] = '\0';
             foundEqual = true;
             foundSemiColon = false;
         }
 
         if (foundEqual && !foundSemiColon && c != '=') {
-            putchar(c);
+            out[used++] = c;
         }
 
-
         if (c == ';' || c == '\t') {
             foundSemiColon = true;
             foundEqual = false;
         }
 
-
         if (c == '\n') {
             foundEqual = false;
             foundSemiColon = false;
         }
 
-        putchar('\0');
+        out[used++] = '\0';
     }
 
-    return 0;
+    st->foundEqual = foundEqual;
+    st->foundSemiColon = foundSemiColon;
+    return used;
+}
+
+/*
+ * The -k filter over a chunk of whole lines. One pass finds every '=', ';',
+ * tab and newline, a vector at a time where there is SSE2; a key is looked
+ * up when its field ends, and its value is only noted until the end of the
+ * line. A line writes at most ncols bytes per input byte, see main
+ */
+size_t project_chunk(const char *in, size_t len, char *out, void *arg) {
+
+    struct projection pj;
+    size_t used = 0;
+    size_t i = 0;
+
+    memset(&pj, 0, sizeof(pj));
+    pj.ks = arg;
+    pj.line = 1;
+
+#ifdef __SSE2__
+    {
+        const __m128i equal = _mm_set1_epi8('=');
+        const __m128i semi = _mm_set1_epi8(';');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+            unsigned mask = _mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, equal), _mm_cmpeq_epi8(v, semi)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, newline))));
+
+            for (; mask != 0; mask &= mask - 1) {
+                used += project_event(&pj, in, i + (size_t) __builtin_ctz(mask), out + used);
+            }
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        if (in[i] == '=' || in[i] == ';' || in[i] == '\t' || in[i] == '\n') {
+            used += project_event(&pj, in, i, out + used);
+        }
+    }
+
+    // The last line of the input may have no newline
+    if (pj.field < len) {
+        end_field(&pj, in, len);
+        used += end_line(&pj, in, out + used);
+    }
+    return used;
+}
+
+/*
+ * Act on the '=', ';', tab or newline at in[at]; returns how many bytes of
+ * output that made, which is only ever a whole line at a newline
+ */
+size_t project_event(struct projection *pj, const char *in, size_t at, char *out) {
+
+    if (in[at] == '=') {
+        if (pj->eq == 0) {
+            pj->eq = at + 1;
+        }
+        return 0;
+    }
+    end_field(pj, in, at);
+    return in[at] == '\n' ? end_line(pj, in, out) : 0;
+}
+
+/*
+ * The field that started at pj->field ends at in[at]: note its value if its
+ * key is one of the listed ones and the line has not had that key yet
+ */
+void end_field(struct projection *pj, const char *in, size_t at) {
+
+    if (pj->eq != 0) {
+        int k = record_key_index(pj->ks, in + pj->field, pj->eq - 1 - pj->field);
+
+        if (k >= 0 && pj->seen[k] != pj->line) {
+            pj->seen[k] = pj->line;
+            pj->val[k] = pj->eq;
+            pj->end[k] = at;
+        }
+    }
+    pj->field = at + 1;
+    pj->eq = 0;
+}
+
+/*
+ * Write the columns of the line to out and move on to the next line;
+ * returns how many bytes were written
+ */
+size_t end_line(struct projection *pj, const char *in, char *out) {
+
+    const struct record_keyset *ks = pj->ks;
+    size_t used = 0;
+
+    for (int col = 0; col < ks->ncols; col++) {
+        int k = ks->cols[col];
+
+        if (col > 0) {
+            out[used++] = '\t';
+        }
+        if (pj->seen[k] == pj->line) {
+            memcpy(out + used, in + pj->val[k], pj->end[k] - pj->val[k]);
+            used += pj->end[k] - pj->val[k];
+        }
+    }
+    out[used++] = '\n';
+    pj->line++;
+    return used;
 }
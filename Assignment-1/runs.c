@@ -0,0 +1,255 @@
+#include    <stdio.h>
+#include    "runs.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include    <immintrin.h>
+#include    <pthread.h>
+#define    RUNS_DISPATCH
+#endif
+
+/*
+ * runs.c
+ *   purpose: run collapsing, see runs.h
+ */
+
+typedef size_t squeeze_fn(const unsigned char *, size_t, unsigned char *);
+
+typedef size_t length_fn(const unsigned char *, size_t, unsigned char);
+
+static size_t squeeze_tail(const unsigned char *, size_t, size_t,
+                           unsigned char *, size_t);
+
+static size_t squeeze_scalar(const unsigned char *, size_t, unsigned char *);
+
+static size_t length_scalar(const unsigned char *, size_t, unsigned char);
+
+#ifdef RUNS_DISPATCH
+static squeeze_fn *squeeze_kernel = squeeze_scalar;
+static length_fn *length_kernel = length_scalar;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+/*
+ * For every 8-bit keep mask, the pshufb indexes that gather the kept bytes
+ * of an 8-byte half to its front, and how many there are
+ */
+static unsigned char shuffles[256][8] __attribute__((aligned(8)));
+static unsigned char counts[256];
+
+static void build_shuffles(void)
+{
+    for (int mask = 0; mask < 256; mask++) {
+        int n = 0;
+        for (int bit = 0; bit < 8; bit++)
+            if (mask & (1 << bit))
+                shuffles[mask][n++] = bit;
+        counts[mask] = n;
+        while (n < 8)
+            shuffles[mask][n++] = 0x80;
+    }
+}
+
+/* from in[1] on every byte's predecessor is in[i - 1], so the shifted
+ * vector is simply an unaligned load one byte earlier */
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi2,popcnt")))
+static size_t squeeze_avx512(const unsigned char *in, size_t len, unsigned char *out)
+{
+    size_t i = 1, n = 0;
+
+    for (; i + 64 <= len; i += 64) {
+        __m512i v = _mm512_loadu_si512(in + i);
+        __m512i before = _mm512_loadu_si512(in + i - 1);
+        __mmask64 keep = _mm512_cmpneq_epi8_mask(v, before);
+
+        _mm512_mask_compressstoreu_epi8(out + n, keep, v);
+        n += __builtin_popcountll(keep);
+    }
+    return squeeze_tail(in, i, len, out, n);
+}
+
+__attribute__((target("ssse3")))
+static size_t squeeze_ssse3(const unsigned char *in, size_t len, unsigned char *out)
+{
+    size_t i = 1, n = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i before = _mm_loadu_si128((const __m128i *) (in + i - 1));
+        unsigned keep = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, before)) & 0xffff;
+        unsigned lo = keep & 0xff;
+        unsigned hi = keep >> 8;
+
+        _mm_storel_epi64((__m128i *) (out + n),
+                         _mm_shuffle_epi8(v, _mm_loadl_epi64((const __m128i *) shuffles[lo])));
+        n += counts[lo];
+        _mm_storel_epi64((__m128i *) (out + n),
+                         _mm_shuffle_epi8(_mm_srli_si128(v, 8),
+                                          _mm_loadl_epi64((const __m128i *) shuffles[hi])));
+        n += counts[hi];
+    }
+    return squeeze_tail(in, i, len, out, n);
+}
+
+__attribute__((target("sse2")))
+static size_t squeeze_sse2(const unsigned char *in, size_t len, unsigned char *out)
+{
+    size_t i = 1, n = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i before = _mm_loadu_si128((const __m128i *) (in + i - 1));
+        unsigned keep = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, before)) & 0xffff;
+
+        if (keep == 0xffff) {
+            _mm_storeu_si128((__m128i *) (out + n), v);
+            n += 16;
+            continue;
+        }
+        for (; keep != 0; keep &= keep - 1)
+            out[n++] = in[i + __builtin_ctz(keep)];
+    }
+    return squeeze_tail(in, i, len, out, n);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t length_avx512(const unsigned char *p, size_t len, unsigned char c)
+{
+    __m512i run = _mm512_set1_epi8((char) c);
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64) {
+        __mmask64 other = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i), run);
+        if (other != 0)
+            return i + __builtin_ctzll(other);
+    }
+    return i + length_scalar(p + i, len - i, c);
+}
+
+__attribute__((target("avx2")))
+static size_t length_avx2(const unsigned char *p, size_t len, unsigned char c)
+{
+    __m256i run = _mm256_set1_epi8((char) c);
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i same = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + i)), run);
+        unsigned other = ~(unsigned) _mm256_movemask_epi8(same);
+        if (other != 0)
+            return i + __builtin_ctz(other);
+    }
+    return i + length_scalar(p + i, len - i, c);
+}
+
+__attribute__((target("sse2")))
+static size_t length_sse2(const unsigned char *p, size_t len, unsigned char c)
+{
+    __m128i run = _mm_set1_epi8((char) c);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i same = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + i)), run);
+        unsigned other = ~_mm_movemask_epi8(same) & 0xffff;
+        if (other != 0)
+            return i + __builtin_ctz(other);
+    }
+    return i + length_scalar(p + i, len - i, c);
+}
+
+static void pick_kernels(void)
+/*
+ * purpose: point squeeze_kernel and length_kernel at the widest kernels
+ *          this CPU can run; the scalar ones stay if it has no SSE2
+ */
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("popcnt"))
+        squeeze_kernel = squeeze_avx512;
+    else if (__builtin_cpu_supports("ssse3")) {
+        build_shuffles();
+        squeeze_kernel = squeeze_ssse3;
+    } else if (__builtin_cpu_supports("sse2"))
+        squeeze_kernel = squeeze_sse2;
+
+    if (__builtin_cpu_supports("avx512bw"))
+        length_kernel = length_avx512;
+    else if (__builtin_cpu_supports("avx2"))
+        length_kernel = length_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        length_kernel = length_sse2;
+}
+#endif
+
+size_t runs_squeeze(const unsigned char *in, size_t len, unsigned char *out,
+                    int *prev)
+/*
+ * purpose: copy the bytes of in[0..len) that differ from the byte before
+ *          them to `out'; the first one is compared with *prev
+ * returns: how many bytes were written; *prev is left at the last byte
+ */
+{
+    size_t n = 0;
+
+    if (len == 0)
+        return 0;
+    if (in[0] != *prev)
+        out[n++] = in[0];
+    *prev = in[len - 1];
+
+#ifdef RUNS_DISPATCH
+    pthread_once(&kernels_once, pick_kernels);
+    return n + squeeze_kernel(in, len, out + n);
+#else
+    return n + squeeze_scalar(in, len, out + n);
+#endif
+}
+
+size_t runs_length(const unsigned char *p, size_t len, unsigned char c)
+/*
+ * purpose: measure the run of `c' at the start of p[0..len)
+ * returns: the index of the first byte that is not `c', or len
+ */
+{
+#ifdef RUNS_DISPATCH
+    pthread_once(&kernels_once, pick_kernels);
+    return length_kernel(p, len, c);
+#else
+    return length_scalar(p, len, c);
+#endif
+}
+
+static size_t squeeze_tail(const unsigned char *in, size_t i, size_t len,
+                           unsigned char *out, size_t n)
+/*
+ * purpose: finish a squeeze kernel from in[i] on, with n bytes written
+ * returns: the total written
+ */
+{
+    for (; i < len; i++) {
+        out[n] = in[i];
+        n += in[i] != in[i - 1];
+    }
+    return n;
+}
+
+static size_t squeeze_scalar(const unsigned char *in, size_t len, unsigned char *out)
+/*
+ * purpose: copy each byte of in[1..len) that differs from the one before
+ * returns: how many bytes were written
+ */
+{
+    return squeeze_tail(in, 1, len, out, 0);
+}
+
+static size_t length_scalar(const unsigned char *p, size_t len, unsigned char c)
+/*
+ * purpose: the plain loop behind every runs_length kernel
+ * returns: the index of the first byte that is not `c', or len
+ */
+{
+    size_t i = 0;
+
+    while (i < len && p[i] == c)
+        i++;
+    return i;
+}
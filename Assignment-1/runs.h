@@ -0,0 +1,36 @@
+#ifndef RUNS_H
+#define RUNS_H
+
+#include    <stddef.h>
+
+/*
+ * runs.h
+ *   purpose: find and collapse runs of a repeated byte, the kernels behind
+ *            uniqc -s, -c and -r
+ *     usage: n = runs_squeeze(in, len, out, &prev) copies in[0..len) to
+ *            out, leaving out each byte that equals the one before it, and
+ *            returns how many bytes it wrote. `prev' is the last byte of the
+ *            previous call, EOF before the first one, and is updated, so a
+ *            stream can be squeezed in stretches of any size.
+ *            n = runs_length(p, len, c) is how many bytes at the start of
+ *            p[0..len) are c, len if all of them are.
+ *     notes: `out' needs room for len + RUNS_SLACK bytes, since the vector
+ *            loops store whole vectors past the last byte they keep. Each
+ *            vector is compared with itself shifted by one byte and the
+ *            bytes that differ are packed together: with vpcompressb on
+ *            AVX-512 VBMI2, with pshufb and a table of shuffles on SSSE3,
+ *            and a bit at a time off an SSE2 mask otherwise.
+ *            runs_length compares a whole vector with c broadcast to every
+ *            byte and takes the first mismatch off the mask, so a long run
+ *            goes by at memory speed. On x86 every kernel is built whatever
+ *            the -march, and the first call picks the widest one the CPU
+ *            has; elsewhere both are plain loops.
+ */
+
+#define    RUNS_SLACK    64
+
+size_t runs_squeeze(const unsigned char *, size_t, unsigned char *, int *);
+
+size_t runs_length(const unsigned char *, size_t, unsigned char);
+
+#endif
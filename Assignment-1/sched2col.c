@@ -0,0 +1,613 @@
+#include    <errno.h>
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    "linereader.h"
+#include    "record.h"
+#include    "schedcol.h"
+
+/*
+ * sched2col.c
+ *   purpose: convert schedule records to the columnar form of schedcol.h,
+ *            or print a columnar file back as records
+ *     input: schedule text on stdin; with -d, a columnar file
+ *    output: the columnar file; with -d, records on stdout
+ *    errors: returns 1 if the input can not be read, the output can not be
+ *            written or a dictionary column has more than
+ *            SCHEDCOL_MAX_WORDS words, 2 on a usage error
+ *     usage: sched2col file.col < sched.txt
+ *            sched2col -d [-w HH:MM-HH:MM] file.col
+ *            -d  print the rows as TR=...;dir=...;day=...;TI=...;stn=...;
+ *                Line=... records. A TR that is missing or not a number and
+ *                a TI that is missing or not HH:MM print as empty values,
+ *                as do missing dir, day, stn and Line fields
+ *            -w  only the rows whose TI is inside the window, ends included;
+ *                either end may be past midnight, up to SCHEDCOL_MAX_HOUR;
+ *                blocks whose TI range misses it are not looked at
+ *     notes: the whole input is held in memory as columns, about 15 bytes
+ *            a record, and written out at the end, each dictionary sorted
+ *            and its column recoded to match. Train ids print as many
+ *            digits wide as they came in.
+ */
+
+#define    DICT_INITIAL_SLOTS    256     /* a power of 2 */
+#define    ROWS_INITIAL          (1 << 16)
+#define    DUMP_BUFSIZE          (1 << 17)
+
+/* the words of a dictionary column in the order they were first seen */
+struct dict {
+    uint32_t *slots;            /* code + 1 by hash, 0 if free          */
+    size_t nslots;
+    uint32_t count;
+    uint32_t *off;              /* start of every word, count + 1 of them */
+    uint32_t off_cap;
+    char *bytes;
+    size_t len;
+    size_t cap;
+};
+
+struct columns {
+    struct record_keyset keys;  /* SCHEDCOL_KEYS, key index = column    */
+    uint64_t rows;
+    uint64_t cap;
+    uint32_t *tr;
+    uint8_t *tr_digits;         /* how TR was written, 0 if NO_TRAIN    */
+    uint16_t *cols[SC_COLUMNS]; /* TI and the codes; unused for TR      */
+    struct dict dicts[SC_COLUMNS];
+    int error;                  /* ENOMEM, E2BIG for too many words,
+                                   EOVERFLOW for a line over 4 GB      */
+};
+
+int convert(struct columns *, int, const char *);
+
+int add_row(const struct record *, void *);
+
+int add_fields(struct columns *, uint64_t, const struct record *, unsigned *);
+
+int grow_rows(struct columns *);
+
+long dict_code(struct dict *, const char *, size_t);
+
+int sort_dict(struct dict *, uint16_t *, uint64_t);
+
+int write_columns(const struct columns *, FILE *);
+
+void put_section(FILE *, const void *, uint64_t, struct schedcol_section *, uint64_t *);
+
+int dump(const char *, const char *);
+
+uint32_t parse_train(const char *, size_t);
+
+uint32_t parse_time(const char *, size_t);
+
+int main(int argc, char *argv[])
+{
+    static struct columns c;
+
+    if (argc == 3 && strcmp(argv[1], "-d") == 0)
+        return dump(argv[2], NULL);
+    if (argc == 5 && strcmp(argv[1], "-d") == 0 && strcmp(argv[2], "-w") == 0)
+        return dump(argv[4], argv[3]);
+    if (argc != 2 || argv[1][0] == '-') {
+        fprintf(stderr, "usage: sched2col file.col < sched.txt\n"
+                        "       sched2col -d [-w HH:MM-HH:MM] file.col\n");
+        return 2;
+    }
+    return convert(&c, 0, argv[1]);
+}
+
+int convert(struct columns *c, int in, const char *path)
+/*
+ * purpose: read the records on `in' into columns and write them to `path'
+ * returns: 0 on success, 1 on any error, which has been reported
+ */
+{
+    struct line_reader lr;
+    struct record rec;
+    const char *block;
+    size_t len, used;
+    FILE *out;
+    int col, rv;
+
+    record_keyset(&c->keys, SCHEDCOL_KEYS);
+    if (lr_init(&lr, in) != 0) {
+        perror("sched2col");
+        return 1;
+    }
+    while (!c->error && lr_block(&lr, &block, &len) != 0) {
+        used = record_scan(block, len, add_row, c);
+        /* record_scan leaves a last line without a newline */
+        if (!c->error && used < len) {
+            record_parse(&rec, block + used, len - used);
+            add_row(&rec, c);
+        }
+    }
+    rv = lr.error;
+    lr_free(&lr);
+    if (rv) {
+        perror("sched2col: read");
+        return 1;
+    }
+
+    for (col = 0; !c->error && col < SC_COLUMNS; col++)
+        if (col != SC_TR && col != SC_TI && sort_dict(&c->dicts[col], c->cols[col], c->rows) != 0)
+            c->error = ENOMEM;
+    if (c->error == E2BIG) {
+        fprintf(stderr, "sched2col: more than %d different values in a column\n", SCHEDCOL_MAX_WORDS);
+        return 1;
+    }
+    if (c->error) {
+        errno = c->error;
+        perror("sched2col");
+        return 1;
+    }
+
+    if ((out = fopen(path, "wb")) == NULL) {
+        perror(path);
+        return 1;
+    }
+    rv = write_columns(c, out);
+    if (fclose(out) != 0)
+        rv = -1;
+    if (rv != 0) {
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+int add_row(const struct record *rec, void *arg)
+/*
+ * purpose: record_scan callback: append one record to the columns
+ * returns: 0 to go on, 1 once c->error is set
+ */
+{
+    struct columns *c = arg;
+    struct record more;
+    uint64_t row = c->rows;
+    unsigned seen = 0;
+    int col;
+
+    if (rec->len == 0)
+        return 0;
+    if (row == c->cap && grow_rows(c) != 0)
+        return 1;
+
+    c->tr[row] = SCHEDCOL_NO_TRAIN;
+    c->tr_digits[row] = 0;
+    c->cols[SC_TI][row] = SCHEDCOL_NO_TIME;
+    if (add_fields(c, row, rec, &seen) != 0)
+        return 1;
+    /* a record too wide for one struct record goes on in the next */
+    while (rec->truncated) {
+        if (rec->rest == 0)
+            return c->error = EOVERFLOW, 1;
+        record_parse(&more, rec->line + rec->rest, rec->len - rec->rest);
+        rec = &more;
+        if (add_fields(c, row, rec, &seen) != 0)
+            return 1;
+    }
+
+    /* a missing field is the empty word */
+    for (col = 0; col < SC_COLUMNS; col++) {
+        long code;
+
+        if (col == SC_TR || col == SC_TI || (seen & 1u << col))
+            continue;
+        if ((code = dict_code(&c->dicts[col], "", 0)) < 0)
+            return c->error = code == -2 ? E2BIG : ENOMEM, 1;
+        c->cols[col][row] = (uint16_t) code;
+    }
+    c->rows++;
+    return 0;
+}
+
+int add_fields(struct columns *c, uint64_t row, const struct record *rec, unsigned *seen)
+/*
+ * purpose: store the fields of `rec' that are columns and not in `seen'
+ *          yet in row `row', adding them to `seen'
+ * returns: 0, or 1 once c->error is set
+ */
+{
+    int i, col;
+
+    for (i = 0; i < rec->nfields; i++) {
+        const struct field_span *f = &rec->fields[i];
+        const char *val = rec->line + f->val_off;
+        long code;
+
+        col = record_key_index(&c->keys, rec->line + f->key_off, f->key_len);
+        if (col < 0 || (*seen & 1u << col))
+            continue;
+        *seen |= 1u << col;
+        if (col == SC_TR) {
+            c->tr[row] = parse_train(val, f->val_len);
+            c->tr_digits[row] = c->tr[row] == SCHEDCOL_NO_TRAIN ? 0 : (uint8_t) f->val_len;
+        }
+        else if (col == SC_TI)
+            c->cols[SC_TI][row] = (uint16_t) parse_time(val, f->val_len);
+        else if ((code = dict_code(&c->dicts[col], val, f->val_len)) >= 0)
+            c->cols[col][row] = (uint16_t) code;
+        else
+            return c->error = code == -2 ? E2BIG : ENOMEM, 1;
+    }
+    return 0;
+}
+
+int grow_rows(struct columns *c)
+/*
+ * purpose: double the room in every column
+ * returns: 0, or -1 with c->error set
+ */
+{
+    uint64_t cap = c->cap ? 2 * c->cap : ROWS_INITIAL;
+    void *p;
+    int col;
+
+    if ((p = realloc(c->tr, cap * sizeof(*c->tr))) == NULL)
+        return c->error = ENOMEM, -1;
+    c->tr = p;
+    if ((p = realloc(c->tr_digits, cap)) == NULL)
+        return c->error = ENOMEM, -1;
+    c->tr_digits = p;
+    for (col = 0; col < SC_COLUMNS; col++) {
+        if (col == SC_TR)
+            continue;
+        if ((p = realloc(c->cols[col], cap * sizeof(*c->cols[col]))) == NULL)
+            return c->error = ENOMEM, -1;
+        c->cols[col] = p;
+    }
+    c->cap = cap;
+    return 0;
+}
+
+static uint32_t word_hash(const char *word, size_t len)
+/*
+ * purpose: FNV-1a, to place a word in a dictionary's slots
+ */
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        h = (h ^ (unsigned char) word[i]) * 16777619u;
+    return h;
+}
+
+long dict_code(struct dict *d, const char *word, size_t len)
+/*
+ * purpose: find `word' in the dictionary, adding it if it is new
+ * returns: its code, -1 if there is no memory, -2 if the dictionary
+ *          already has SCHEDCOL_MAX_WORDS words
+ */
+{
+    size_t mask, i;
+    uint32_t code;
+
+    if (d->nslots == 0 || 2 * (d->count + 1) > d->nslots) {
+        /* keep the table at most half full, rehashing into twice the slots */
+        size_t nslots = d->nslots ? 2 * d->nslots : DICT_INITIAL_SLOTS;
+        uint32_t *slots = calloc(nslots, sizeof(*slots));
+
+        if (slots == NULL)
+            return -1;
+        for (code = 0; code < d->count; code++) {
+            i = word_hash(d->bytes + d->off[code], d->off[code + 1] - d->off[code]) & (nslots - 1);
+            while (slots[i] != 0)
+                i = (i + 1) & (nslots - 1);
+            slots[i] = code + 1;
+        }
+        free(d->slots);
+        d->slots = slots;
+        d->nslots = nslots;
+    }
+
+    mask = d->nslots - 1;
+    for (i = word_hash(word, len) & mask; d->slots[i] != 0; i = (i + 1) & mask) {
+        code = d->slots[i] - 1;
+        if (d->off[code + 1] - d->off[code] == len && memcmp(d->bytes + d->off[code], word, len) == 0)
+            return code;
+    }
+
+    if (d->count == SCHEDCOL_MAX_WORDS)
+        return -2;
+    if (d->count + 2 > d->off_cap) {
+        uint32_t cap = d->off_cap ? 2 * d->off_cap : DICT_INITIAL_SLOTS;
+        uint32_t *off = realloc(d->off, cap * sizeof(*off));
+
+        if (off == NULL)
+            return -1;
+        if (d->off_cap == 0)
+            off[0] = 0;
+        d->off = off;
+        d->off_cap = cap;
+    }
+    if (d->len + len > d->cap) {
+        size_t cap = d->cap ? d->cap : DICT_INITIAL_SLOTS;
+        char *bytes;
+
+        while (cap < d->len + len)
+            cap *= 2;
+        if ((bytes = realloc(d->bytes, cap)) == NULL)
+            return -1;
+        d->bytes = bytes;
+        d->cap = cap;
+    }
+    memcpy(d->bytes + d->len, word, len);
+    d->len += len;
+    code = d->count++;
+    d->off[d->count] = (uint32_t) d->len;
+    d->slots[i] = code + 1;
+    return code;
+}
+
+/* the dictionary being sorted, for compare_words */
+static const struct dict *sorting;
+
+static int compare_words(const void *a, const void *b)
+/*
+ * purpose: qsort order of two codes of `sorting': bytewise, a word before
+ *          any longer word it is the start of
+ */
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    size_t nx = sorting->off[x + 1] - sorting->off[x];
+    size_t ny = sorting->off[y + 1] - sorting->off[y];
+    int cmp = memcmp(sorting->bytes + sorting->off[x], sorting->bytes + sorting->off[y], nx < ny ? nx : ny);
+
+    return cmp != 0 ? cmp : (nx > ny) - (nx < ny);
+}
+
+int sort_dict(struct dict *d, uint16_t *codes, uint64_t rows)
+/*
+ * purpose: put the words of `d' in order and recode its column to match
+ * returns: 0, or -1 if there is no memory
+ */
+{
+    uint32_t *order = malloc((d->count + 1) * sizeof(*order));
+    uint32_t *recode = malloc((d->count + 1) * sizeof(*recode));
+    uint32_t *off = malloc((d->count + 1) * sizeof(*off));
+    char *bytes = malloc(d->len + 1);
+    uint32_t code;
+    uint64_t row;
+    size_t len = 0;
+
+    if (order == NULL || recode == NULL || off == NULL || bytes == NULL) {
+        free(order);
+        free(recode);
+        free(off);
+        free(bytes);
+        return -1;
+    }
+
+    for (code = 0; code < d->count; code++)
+        order[code] = code;
+    sorting = d;
+    qsort(order, d->count, sizeof(*order), compare_words);
+
+    off[0] = 0;
+    for (code = 0; code < d->count; code++) {
+        uint32_t old = order[code];
+        size_t n = d->off[old + 1] - d->off[old];
+
+        memcpy(bytes + len, d->bytes + d->off[old], n);
+        len += n;
+        off[code + 1] = (uint32_t) len;
+        recode[old] = code;
+    }
+    for (row = 0; row < rows; row++)
+        codes[row] = (uint16_t) recode[codes[row]];
+
+    /* the slots still index the old codes; nothing looks words up any more */
+    free(d->slots);
+    d->slots = NULL;
+    d->nslots = 0;
+    free(d->off);
+    free(d->bytes);
+    d->off = off;
+    d->off_cap = d->count + 1;
+    d->bytes = bytes;
+    d->cap = d->len + 1;
+    free(order);
+    free(recode);
+    return 0;
+}
+
+int write_columns(const struct columns *c, FILE *out)
+/*
+ * purpose: write the header, the columns, their dictionaries and the
+ *          block ranges
+ * returns: 0, or -1 if writing or allocating failed
+ */
+{
+    struct schedcol_header h;
+    struct schedcol_range *stats;
+    uint64_t blocks = (c->rows + SCHEDCOL_BLOCK_ROWS - 1) / SCHEDCOL_BLOCK_ROWS;
+    uint64_t at = sizeof(h);
+    int col;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SCHEDCOL_MAGIC, sizeof(h.magic));
+    h.endian = SCHEDCOL_ENDIAN;
+    h.block_rows = SCHEDCOL_BLOCK_ROWS;
+    h.rows = c->rows;
+
+    /* the header goes first, but its offsets are only known at the end */
+    if (fseek(out, (long) sizeof(h), SEEK_SET) != 0)
+        return -1;
+    if ((stats = malloc((blocks + 1) * sizeof(*stats))) == NULL)
+        return -1;
+
+    for (col = 0; col < SC_COLUMNS; col++) {
+        /* a uint16 code is never NO_TRAIN, so the dictionary columns have no marker */
+        uint32_t none = col == SC_TI ? SCHEDCOL_NO_TIME : SCHEDCOL_NO_TRAIN;
+        uint64_t b, row;
+
+        if (col == SC_TR)
+            put_section(out, c->tr, c->rows * sizeof(*c->tr), &h.data[col], &at);
+        else
+            put_section(out, c->cols[col], c->rows * sizeof(*c->cols[col]), &h.data[col], &at);
+
+        for (b = 0; b < blocks; b++) {
+            uint64_t end = (b + 1) * SCHEDCOL_BLOCK_ROWS < c->rows ? (b + 1) * SCHEDCOL_BLOCK_ROWS : c->rows;
+
+            stats[b].min = UINT32_MAX;
+            stats[b].max = 0;
+            for (row = b * SCHEDCOL_BLOCK_ROWS; row < end; row++) {
+                uint32_t v = col == SC_TR ? c->tr[row] : c->cols[col][row];
+                if (v == none)
+                    continue;
+                if (v < stats[b].min)
+                    stats[b].min = v;
+                if (v > stats[b].max)
+                    stats[b].max = v;
+            }
+        }
+        put_section(out, stats, blocks * sizeof(*stats), &h.stats[col], &at);
+
+        if (col != SC_TR && col != SC_TI) {
+            const struct dict *d = &c->dicts[col];
+            uint32_t count = d->count;
+            uint64_t start = at;
+
+            put_section(out, &count, sizeof(count), &h.dict[col], &at);
+            fwrite(d->off, sizeof(*d->off), count + 1, out);
+            fwrite(d->bytes, 1, d->len, out);
+            /* one section: count, offsets and words */
+            at += (count + 1) * sizeof(*d->off) + d->len;
+            h.dict[col].off = start;
+            h.dict[col].len = at - start;
+        }
+    }
+    free(stats);
+    put_section(out, c->tr_digits, c->rows, &h.tr_digits, &at);
+
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, out) != 1)
+        return -1;
+    return ferror(out) ? -1 : 0;
+}
+
+void put_section(FILE *out, const void *data, uint64_t len, struct schedcol_section *s, uint64_t *at)
+/*
+ * purpose: pad the file to 8 bytes, write `len' bytes and note where
+ *          they went in *s; *at is kept at the end of the file
+ */
+{
+    static const char zeros[8];
+    size_t pad = (size_t) (-*at & 7);
+
+    fwrite(zeros, 1, pad, out);
+    *at += pad;
+    s->off = *at;
+    s->len = len;
+    if (len > 0)
+        fwrite(data, 1, len, out);
+    *at += len;
+}
+
+int dump(const char *path, const char *window)
+/*
+ * purpose: print the rows of the columnar file `path', those with a TI in
+ *          `window' if it is not NULL
+ * returns: 0, 1 if the file can not be read or stdout written, 2 if the
+ *          window is malformed
+ */
+{
+    static char buf[DUMP_BUFSIZE];
+    struct schedcol sc;
+    uint32_t lo = 0, hi = SCHEDCOL_NO_TIME - 1;
+    uint64_t b, row;
+    FILE *in;
+    int rv;
+
+    if (window != NULL) {
+        const char *dash = strchr(window, '-');
+        if (dash == NULL || (lo = parse_time(window, dash - window)) == SCHEDCOL_NO_TIME
+            || (hi = parse_time(dash + 1, strlen(dash + 1))) == SCHEDCOL_NO_TIME) {
+            fprintf(stderr, "sched2col: the window is HH:MM-HH:MM\n");
+            return 2;
+        }
+    }
+    if ((in = fopen(path, "rb")) == NULL || schedcol_open(&sc, fileno(in)) != 0) {
+        perror(path);
+        return 1;
+    }
+    fclose(in);
+    setvbuf(stdout, buf, _IOFBF, sizeof(buf));
+
+    for (b = 0; b < sc.blocks; b++) {
+        uint64_t end = (b + 1) * sc.block_rows < sc.rows ? (b + 1) * sc.block_rows : sc.rows;
+
+        if (window != NULL && (sc.stats[SC_TI][b].min > hi || sc.stats[SC_TI][b].max < lo))
+            continue;
+        for (row = b * sc.block_rows; row < end; row++) {
+            const char *word[SC_COLUMNS];
+            size_t len[SC_COLUMNS];
+            int col;
+
+            if (window != NULL && (sc.ti[row] < lo || sc.ti[row] > hi))
+                continue;
+            for (col = 0; col < SC_COLUMNS; col++) {
+                if (sc.codes[col] != NULL && (word[col] = schedcol_word(&sc, col, sc.codes[col][row], &len[col])) == NULL) {
+                    word[col] = "";
+                    len[col] = 0;
+                }
+            }
+            if (sc.tr[row] == SCHEDCOL_NO_TRAIN)
+                fputs("TR=", stdout);
+            else
+                printf("TR=%0*u", (int) sc.tr_digits[row], (unsigned) sc.tr[row]);
+            printf(";dir=%.*s;day=%.*s", (int) len[SC_DIR], word[SC_DIR], (int) len[SC_DAY], word[SC_DAY]);
+            if (sc.ti[row] == SCHEDCOL_NO_TIME)
+                fputs(";TI=", stdout);
+            else
+                printf(";TI=%02u:%02u", sc.ti[row] / 60u, sc.ti[row] % 60u);
+            printf(";stn=%.*s;Line=%.*s\n", (int) len[SC_STN], word[SC_STN], (int) len[SC_LINE], word[SC_LINE]);
+        }
+    }
+
+    rv = fflush(stdout) != 0;
+    schedcol_close(&sc);
+    return rv;
+}
+
+uint32_t parse_train(const char *p, size_t len)
+/*
+ * purpose: read a train id
+ * returns: its number, or SCHEDCOL_NO_TRAIN if it is empty, longer than
+ *          nine digits or not all digits
+ */
+{
+    uint32_t n = 0;
+    size_t i;
+
+    if (len == 0 || len > 9)
+        return SCHEDCOL_NO_TRAIN;
+    for (i = 0; i < len; i++) {
+        if (p[i] < '0' || p[i] > '9')
+            return SCHEDCOL_NO_TRAIN;
+        n = n * 10 + (uint32_t) (p[i] - '0');
+    }
+    return n;
+}
+
+uint32_t parse_time(const char *p, size_t len)
+/*
+ * purpose: read an HH:MM time; the hour may run past midnight up to
+ *          SCHEDCOL_MAX_HOUR, the way a service day ends
+ * returns: minutes since the start of the day, or SCHEDCOL_NO_TIME
+ */
+{
+    int i, hour, minute;
+
+    if (len != 5 || p[2] != ':')
+        return SCHEDCOL_NO_TIME;
+    for (i = 0; i < 5; i++)
+        if (i != 2 && (p[i] < '0' || p[i] > '9'))
+            return SCHEDCOL_NO_TIME;
+    hour = (p[0] - '0') * 10 + (p[1] - '0');
+    minute = (p[3] - '0') * 10 + (p[4] - '0');
+    if (hour > SCHEDCOL_MAX_HOUR || minute > 59)
+        return SCHEDCOL_NO_TIME;
+    return (uint32_t) (hour * 60 + minute);
+}
@@ -0,0 +1,164 @@
+#include    <errno.h>
+#include    <string.h>
+#include    <sys/mman.h>
+#include    "input.h"
+#include    "schedcol.h"
+
+/*
+ * schedcol.c
+ *   purpose: reader for the columnar schedule files, see schedcol.h
+ */
+
+static const void *section(const struct schedcol *, const struct schedcol_section *, uint64_t);
+
+static int open_dict(struct schedcol *, int, const struct schedcol_section *);
+
+int schedcol_open(struct schedcol *sc, int fd)
+/*
+ * purpose: map the file open on `fd' and point `sc' at its columns
+ * returns: 0, or -1 with errno set; EINVAL if it is not a well formed
+ *          schedcol file
+ */
+{
+    static const uint64_t width[SC_COLUMNS] = {4, 2, 2, 2, 2, 2};
+    struct input in;
+    const struct schedcol_header *h;
+    int col;
+
+    memset(sc, 0, sizeof(*sc));
+    errno = 0;
+    if (in_map(&in, fd) != 0) {
+        if (errno == 0)
+            errno = EINVAL;
+        return -1;
+    }
+    sc->base = in.base;
+    sc->size = in.size;
+
+    h = (const struct schedcol_header *) sc->base;
+    if (sc->size < sizeof(*h) || memcmp(h->magic, SCHEDCOL_MAGIC, sizeof(h->magic)) != 0
+        || h->endian != SCHEDCOL_ENDIAN || h->block_rows == 0 || h->rows > sc->size)
+        goto bad;
+    sc->rows = h->rows;
+    sc->block_rows = h->block_rows;
+    sc->blocks = (uint32_t) ((h->rows + h->block_rows - 1) / h->block_rows);
+
+    for (col = 0; col < SC_COLUMNS; col++) {
+        const void *data = section(sc, &h->data[col], h->rows * width[col]);
+
+        sc->stats[col] = section(sc, &h->stats[col], (uint64_t) sc->blocks * sizeof(struct schedcol_range));
+        if (data == NULL || sc->stats[col] == NULL)
+            goto bad;
+        if (col == SC_TR)
+            sc->tr = data;
+        else if (col == SC_TI)
+            sc->ti = data;
+        else if (open_dict(sc, col, &h->dict[col]) == 0)
+            sc->codes[col] = data;
+        else
+            goto bad;
+    }
+    if ((sc->tr_digits = section(sc, &h->tr_digits, h->rows)) == NULL)
+        goto bad;
+    return 0;
+
+bad:
+    schedcol_close(sc);
+    errno = EINVAL;
+    return -1;
+}
+
+static const void *section(const struct schedcol *sc, const struct schedcol_section *s, uint64_t len)
+/*
+ * purpose: find a section that should be `len' bytes long
+ * returns: its start, or NULL if it is another length, is not 8-byte
+ *          aligned or does not lie inside the file
+ */
+{
+    if (s->len != len || s->off % 8 != 0 || s->off > sc->size || s->len > sc->size - s->off)
+        return NULL;
+    return sc->base + s->off;
+}
+
+static int open_dict(struct schedcol *sc, int col, const struct schedcol_section *s)
+/*
+ * purpose: point `sc' at the dictionary of column `col'
+ * returns: 0, or -1 if it is cut short or its offsets go backwards or
+ *          past its words
+ */
+{
+    const uint32_t *off;
+    uint64_t count, words;
+    uint32_t i;
+
+    if (s->len < 4 || (off = section(sc, s, s->len)) == NULL)
+        return -1;
+    count = off[0];
+    if (count > SCHEDCOL_MAX_WORDS || (count + 2) * 4 > s->len)
+        return -1;
+    off++;
+    words = s->len - (count + 2) * 4;
+    if (off[0] != 0 || off[count] != words)
+        return -1;
+    for (i = 0; i < count; i++)
+        if (off[i] > off[i + 1])
+            return -1;
+
+    sc->words[col] = (uint32_t) count;
+    sc->word_off[col] = off;
+    sc->word_bytes[col] = (const char *) (off + count + 1);
+    return 0;
+}
+
+const char *schedcol_word(const struct schedcol *sc, int col, uint32_t code, size_t *len)
+/*
+ * purpose: look up a code of a dictionary column
+ * returns: the word, not NUL terminated, with its length in *len, or
+ *          NULL if `col' has no dictionary or the code is not in it
+ */
+{
+    const uint32_t *off = sc->word_off[col];
+
+    if (off == NULL || code >= sc->words[col])
+        return NULL;
+    *len = off[code + 1] - off[code];
+    return sc->word_bytes[col] + off[code];
+}
+
+long schedcol_code(const struct schedcol *sc, int col, const char *word, size_t len)
+/*
+ * purpose: find the code of `word' in the dictionary of column `col'
+ * returns: the code, or -1 if the word never occurs in the column
+ */
+{
+    const uint32_t *off = sc->word_off[col];
+    uint32_t lo = 0, hi = sc->words[col];
+
+    /* the words are sorted, bytewise and shorter first on a tie */
+    while (off != NULL && lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        size_t n = off[mid + 1] - off[mid];
+        int cmp = memcmp(sc->word_bytes[col] + off[mid], word, n < len ? n : len);
+
+        if (cmp == 0)
+            cmp = n < len ? -1 : n > len;
+        if (cmp == 0)
+            return mid;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+void schedcol_close(struct schedcol *sc)
+/*
+ * purpose: unmap the file
+ */
+{
+    if (sc->base != NULL)
+        munmap((void *) sc->base, sc->size);
+    sc->base = NULL;
+    sc->size = 0;
+}
@@ -0,0 +1,102 @@
+#ifndef SCHEDCOL_H
+#define SCHEDCOL_H
+
+#include    <stddef.h>
+#include    <stdint.h>
+
+/*
+ * schedcol.h
+ *   purpose: a columnar binary form of the schedule feed, so a query can
+ *            map a file and read its columns as arrays instead of parsing
+ *            TR=...;dir=...;day=...;TI=...;stn=...;Line=... text again
+ *     usage: sched2col writes the file (see sched2col.c). To read it,
+ *            schedcol_open(&sc, fd) maps it and points sc.tr, sc.ti and
+ *            sc.codes[] at the columns; row r of a dictionary column is
+ *            schedcol_word(&sc, col, sc.codes[col][r], &len), and
+ *            schedcol_code() turns a word into its code for comparisons.
+ *            sc.stats[col][b] is the range of block b, rows
+ *            b * sc.block_rows up to the next block.
+ *    layout: a struct schedcol_header, then the sections it points at,
+ *            each 8-byte aligned, in the byte order of the machine that
+ *            wrote the file (the header's endian field says which):
+ *              TR      uint32 per row, SCHEDCOL_NO_TRAIN if missing or
+ *                      not a number
+ *              TI      uint16 minutes since the midnight that starts the
+ *                      service day per row, so a train that runs on past
+ *                      midnight has times up to SCHEDCOL_MAX_HOUR:59;
+ *                      SCHEDCOL_NO_TIME if missing or not HH:MM
+ *              dir, day, stn, Line
+ *                      uint16 dictionary code per row. A dictionary is a
+ *                      uint32 count, count + 1 uint32 offsets into the
+ *                      bytes that follow, and the words, sorted, so codes
+ *                      compare the way the words do. A missing field is
+ *                      the empty word.
+ *              stats   a struct schedcol_range per block for every column,
+ *                      the smallest and largest value other than the
+ *                      NO_ markers; min > max for a block without any
+ *              TR digits
+ *                      uint8 per row, how many digits TR was written with,
+ *                      leading zeros included; 0 for SCHEDCOL_NO_TRAIN
+ *     notes: fields other than the six are not kept. Opening checks that
+ *            every section lies inside the file, nothing is parsed.
+ */
+
+#define    SCHEDCOL_MAGIC         "SCHEDCL2"
+#define    SCHEDCOL_ENDIAN        0x01020304u
+#define    SCHEDCOL_BLOCK_ROWS    65536
+#define    SCHEDCOL_MAX_WORDS     65536     /* codes are uint16 */
+#define    SCHEDCOL_NO_TRAIN      0xffffffffu
+#define    SCHEDCOL_NO_TIME       0xffffu
+#define    SCHEDCOL_MAX_HOUR      47
+
+enum schedcol_column { SC_TR, SC_DIR, SC_DAY, SC_TI, SC_STN, SC_LINE, SC_COLUMNS };
+
+/* the keys of the columns in enum order, for record_keyset */
+#define    SCHEDCOL_KEYS    "TR,dir,day,TI,stn,Line"
+
+struct schedcol_range {
+    uint32_t min;
+    uint32_t max;
+};
+
+struct schedcol_section {
+    uint64_t off;               /* from the start of the file          */
+    uint64_t len;               /* in bytes                            */
+};
+
+struct schedcol_header {
+    char magic[8];              /* SCHEDCOL_MAGIC, without its NUL     */
+    uint32_t endian;            /* SCHEDCOL_ENDIAN as written          */
+    uint32_t block_rows;        /* rows per block of the stats         */
+    uint64_t rows;
+    struct schedcol_section data[SC_COLUMNS];
+    struct schedcol_section stats[SC_COLUMNS];
+    struct schedcol_section dict[SC_COLUMNS];   /* len 0 for TR and TI */
+    struct schedcol_section tr_digits;
+};
+
+struct schedcol {
+    const char *base;           /* the mapping                         */
+    size_t size;
+    uint64_t rows;
+    uint32_t block_rows;
+    uint32_t blocks;
+    const uint32_t *tr;
+    const uint8_t *tr_digits;
+    const uint16_t *ti;
+    const uint16_t *codes[SC_COLUMNS];          /* NULL for TR and TI  */
+    const struct schedcol_range *stats[SC_COLUMNS];
+    uint32_t words[SC_COLUMNS];                 /* dictionary sizes    */
+    const uint32_t *word_off[SC_COLUMNS];
+    const char *word_bytes[SC_COLUMNS];
+};
+
+int schedcol_open(struct schedcol *, int);
+
+const char *schedcol_word(const struct schedcol *, int, uint32_t, size_t *);
+
+long schedcol_code(const struct schedcol *, int, const char *, size_t);
+
+void schedcol_close(struct schedcol *);
+
+#endif
@@ -1,22 +1,440 @@
 #include    <stdio.h>
+#include    <string.h>
+#include    <unistd.h>
+#include    <errno.h>
+#include    "passthru.h"
+#include    "parallel.h"
+
+#ifdef __SSE2__
+#include    <emmintrin.h>
+#endif
 
 /*
  * semi2tab2.c
  *   purpose: filter data replacing semicolons with tab chars
  *     input: text
  *    output: text with tabs in place of semicolons
- *    errors: no error conditions
- *     usage: semi2tab < input > output
+ *    errors: returns 1 if stdin can not be read or stdout can not be written,
+ *            2 if a mapping argument is malformed
+ *     usage: semi2tab [-s | -z] [-j N] [mapping ...] < input > output
+ *            -s  use the original one-char-at-a-time stdio loop
+ *            -z  when stdin is a regular file, leave runs of PASSTHRU_MIN
+ *                or more unchanged bytes to the kernel (see passthru.h);
+ *                otherwise the same as the default
+ *            -j  translate on N threads (see parallel.h); overrides -s, -z
+ *            a mapping is FROM=TO to rewrite byte FROM as byte TO, or
+ *            FROM= to drop byte FROM. Either side may be one of the
+ *            escapes \t \n \r \0 \\. With no mappings the filter does ;=\t
+ *   example: semi2tab2 ';=\t' ',=\t' '\r=' < export.csv
  *     notes: version 2 uses the more compact C syntax
+ *            the mappings are compiled into a 256 entry table at startup
+ *            and applied to BLOCK_SIZE blocks read from stdin, each block
+ *            leaving in a single write call. When the only mapping is a
+ *            single replacement the block path finds it with memchr (glibc
+ *            picks the SSE2/AVX2 version at load time) instead, and with
+ *            up to VECTOR_CHANGES changed bytes it rewrites 16 bytes at a
+ *            time with SSE2 compares and blends (see translate_vector).
+ *            Output is byte for byte the same as -s.
+ */
+
+#define    BLOCK_SIZE    (1 << 17)
+#define    FROM_CHAR     ';'
+#define    TO_CHAR       '\t'
+#define    VECTOR_CHANGES    8       /* most changed bytes translate_vector takes */
+
+struct translation {
+    unsigned char to[256];      /* replacement for each byte        */
+    unsigned char keep[256];    /* 1 to emit the byte, 0 to drop it */
+    int changes;                /* number of bytes not mapped to themselves */
+    int drops;                  /* number of bytes dropped          */
+    unsigned char from_char;    /* the byte, when changes == 1      */
+    unsigned char from[VECTOR_CHANGES]; /* the changed bytes, when there
+                                           are no more than VECTOR_CHANGES */
+};
+
+void init_translation(struct translation *);
+
+int add_mapping(struct translation *, const char *);
+
+void count_changes(struct translation *);
+
+int parse_byte(const char **, unsigned char *);
+
+int stream_filter(const struct translation *);
+
+int block_filter(const struct translation *, int, int);
+
+size_t translate_block(const struct translation *, unsigned char *, size_t);
+
+size_t translate_vector(const struct translation *, unsigned char *, size_t);
+
+size_t translate_chunk(const char *, size_t, char *, void *);
+
+int splice_filter(const struct translation *, struct passthru *);
+
+const unsigned char *next_change(const struct translation *,
+                                 const unsigned char *, const unsigned char *);
+
+int main(int argc, char *argv[]) {
+    struct translation tr;
+    struct passthru pt;
+    int stream = 0, splice = 0;
+    int jobs = par_take_jobs(&argc, argv);
+    int i = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        stream = 1;
+        i++;
+    } else if (argc > 1 && strcmp(argv[1], "-z") == 0) {
+        splice = 1;
+        i++;
+    }
+
+    init_translation(&tr);
+    if (i == argc)
+        tr.to[FROM_CHAR] = TO_CHAR;
+    for (; i < argc; i++)
+        if (add_mapping(&tr, argv[i]) != 0) {
+            fprintf(stderr, "semi2tab2: bad mapping `%s'\n", argv[i]);
+            return 2;
+        }
+    count_changes(&tr);
+
+    if (jobs > 1)
+        return par_filter(0, 1, jobs, 1, translate_chunk, &tr) < 0;
+    if (stream)
+        return stream_filter(&tr);
+    if (splice && tr.changes > 0 && passthru_open(&pt, 0, 1) == 0)
+        return splice_filter(&tr, &pt);
+    return block_filter(&tr, 0, 1);
+}
+
+void init_translation(struct translation *tr)
+/*
+ * purpose: set `tr' to the identity translation
+ */
+{
+    int c;
+
+    for (c = 0; c < 256; c++) {
+        tr->to[c] = (unsigned char) c;
+        tr->keep[c] = 1;
+    }
+    tr->changes = 0;
+    tr->drops = 0;
+    tr->from_char = 0;
+}
+
+int add_mapping(struct translation *tr, const char *arg)
+/*
+ * purpose: add one FROM=TO or FROM= mapping to `tr'
+ * returns: 0 on success, -1 if `arg' is malformed
+ *   notes: a later mapping for the same byte replaces the earlier one
+ */
+{
+    unsigned char from, to;
+
+    if (parse_byte(&arg, &from) != 0 || *arg++ != '=')
+        return -1;
+
+    if (*arg == '\0') {
+        tr->to[from] = from;
+        tr->keep[from] = 0;
+        return 0;
+    }
+    if (parse_byte(&arg, &to) != 0 || *arg != '\0')
+        return -1;
+    tr->to[from] = to;
+    tr->keep[from] = 1;
+    return 0;
+}
+
+void count_changes(struct translation *tr)
+/*
+ * purpose: fill in the changes/drops/from_char summary of `tr'
  */
+{
+    int c;
 
-int main() {
+    tr->changes = 0;
+    tr->drops = 0;
+    for (c = 0; c < 256; c++) {
+        if (!tr->keep[c])
+            tr->drops++;
+        if (tr->to[c] != c || !tr->keep[c]) {
+            if (tr->changes < VECTOR_CHANGES)
+                tr->from[tr->changes] = (unsigned char) c;
+            tr->changes++;
+            tr->from_char = (unsigned char) c;
+        }
+    }
+}
+
+int parse_byte(const char **sp, unsigned char *out)
+/*
+ * purpose: read one plain or backslash-escaped byte from *sp and advance it
+ * returns: 0 on success, -1 on an empty string or an unknown escape
+ */
+{
+    const char *s = *sp;
+
+    if (*s == '\0')
+        return -1;
+    if (*s != '\\') {
+        *out = (unsigned char) *s;
+        *sp = s + 1;
+        return 0;
+    }
+    switch (s[1]) {
+        case 't':
+            *out = '\t';
+            break;
+        case 'n':
+            *out = '\n';
+            break;
+        case 'r':
+            *out = '\r';
+            break;
+        case '0':
+            *out = '\0';
+            break;
+        case '\\':
+            *out = '\\';
+            break;
+        default:
+            return -1;
+    }
+    *sp = s + 2;
+    return 0;
+}
+
+int stream_filter(const struct translation *tr)
+/*
+ * purpose: the original filter, one getchar/putchar per byte
+ */
+{
     int c;        // this is ok as a comment, too
     while ((c = getchar()) != EOF) {
-        if (c == ';') {
-            c = '\t';    /* replace		*/
+        if (!tr->keep[c]) {
+            continue;       /* drop			*/
         }
+        c = tr->to[c];      /* replace		*/
         putchar(c);        /* send to output	*/
     }
     return 0;
 }
+
+int block_filter(const struct translation *tr, int in, int out)
+/*
+ * purpose: translate `in' to `out' a block at a time
+ * returns: 0 on success, 1 on a read or write error
+ */
+{
+    static unsigned char block[BLOCK_SIZE];
+    ssize_t n;
+    size_t len;
+
+    for (;;) {
+        n = read(in, block, BLOCK_SIZE);
+        if (n == 0)
+            return 0;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("semi2tab2: read");
+            return 1;
+        }
+
+        len = translate_block(tr, block, n);
+
+        if (passthru_write(out, block, len) != 0) {
+            perror("semi2tab2: write");
+            return 1;
+        }
+    }
+}
+
+size_t translate_block(const struct translation *tr, unsigned char *buf, size_t len)
+/*
+ * purpose: apply `tr' to `buf' in place
+ * returns: the number of bytes left in `buf' after drops
+ */
+{
+    unsigned char *p, *end = buf + len;
+    size_t i, j;
+
+    if (tr->changes == 0)
+        return len;
+
+    if (tr->changes == 1 && tr->drops == 0) {
+        for (p = buf; (p = memchr(p, tr->from_char, end - p)) != NULL; p++)
+            *p = tr->to[tr->from_char];
+        return len;
+    }
+
+#ifdef __SSE2__
+    if (tr->changes <= VECTOR_CHANGES)
+        return translate_vector(tr, buf, len);
+#endif
+
+    if (tr->drops == 0) {
+        for (i = 0; i < len; i++)
+            buf[i] = tr->to[buf[i]];
+        return len;
+    }
+
+    /* store every byte, but only advance past the ones we keep */
+    for (i = j = 0; i < len; i++) {
+        unsigned char c = buf[i];
+        buf[j] = tr->to[c];
+        j += tr->keep[c];
+    }
+    return j;
+}
+
+#ifdef __SSE2__
+size_t translate_vector(const struct translation *tr, unsigned char *buf, size_t len)
+/*
+ * purpose: translate_block for up to VECTOR_CHANGES changed bytes: every
+ *          16 bytes are compared with each FROM byte and its TO byte is
+ *          blended in where they match. A vector that holds a dropped byte
+ *          is done a byte at a time, the others are stored whole
+ * returns: the number of bytes left in `buf' after drops
+ *   notes: the output never gets ahead of the input, so a store only
+ *          covers bytes that have been loaded already
+ */
+{
+    __m128i from[VECTOR_CHANGES], to[VECTOR_CHANGES];
+    int dropped[VECTOR_CHANGES];
+    size_t i = 0, j = 0, b;
+    int k, n = tr->changes;
+
+    for (k = 0; k < n; k++) {
+        from[k] = _mm_set1_epi8((char) tr->from[k]);
+        to[k] = _mm_set1_epi8((char) tr->to[tr->from[k]]);
+        dropped[k] = !tr->keep[tr->from[k]];
+    }
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (buf + i));
+        __m128i out = v;
+        unsigned drop = 0;
+
+        for (k = 0; k < n; k++) {
+            __m128i hit = _mm_cmpeq_epi8(v, from[k]);
+            out = _mm_or_si128(_mm_andnot_si128(hit, out), _mm_and_si128(hit, to[k]));
+            if (dropped[k])
+                drop |= _mm_movemask_epi8(hit);
+        }
+        if (drop == 0) {
+            _mm_storeu_si128((__m128i *) (buf + j), out);
+            j += 16;
+            continue;
+        }
+        for (b = i; b < i + 16; b++) {
+            unsigned char c = buf[b];
+            buf[j] = tr->to[c];
+            j += tr->keep[c];
+        }
+    }
+
+    for (; i < len; i++) {
+        unsigned char c = buf[i];
+        buf[j] = tr->to[c];
+        j += tr->keep[c];
+    }
+    return j;
+}
+#endif
+
+size_t translate_chunk(const char *in, size_t len, char *out, void *tr)
+/*
+ * purpose: par_fn for -j: translate one chunk of lines into `out'
+ */
+{
+    memcpy(out, in, len);
+    return translate_block(tr, (unsigned char *) out, len);
+}
+
+int splice_filter(const struct translation *tr, struct passthru *pt)
+/*
+ * purpose: translate the mapped stdin, passing long unchanged runs through
+ *          the kernel and collecting everything else in one output block
+ * returns: 0 on success, 1 on a write error
+ */
+{
+    static unsigned char block[BLOCK_SIZE];
+    const unsigned char *base = pt->base, *end = base + pt->size;
+    const unsigned char *p = base, *q;
+    size_t len = 0, gap;
+    int rv = 0;
+
+    while (p < end) {
+        q = next_change(tr, p, end);
+        gap = q - p;
+
+        if (gap >= PASSTHRU_MIN) {
+            if (passthru_write(pt->out, block, len) != 0
+                || passthru_span(pt, p - base, gap) != 0) {
+                rv = 1;
+                break;
+            }
+            len = 0;
+        } else {
+            /* short run: copy it, flushing the block as it fills */
+            while (gap > 0) {
+                size_t room = BLOCK_SIZE - len;
+                size_t n = gap < room ? gap : room;
+                memcpy(block + len, p, n);
+                len += n;
+                p += n;
+                gap -= n;
+                if (len == BLOCK_SIZE) {
+                    if (passthru_write(pt->out, block, len) != 0) {
+                        rv = 1;
+                        goto done;
+                    }
+                    len = 0;
+                }
+            }
+        }
+
+        if (q == end)
+            break;
+        if (tr->keep[*q])
+            block[len++] = tr->to[*q];
+        p = q + 1;
+        if (len == BLOCK_SIZE) {
+            if (passthru_write(pt->out, block, len) != 0) {
+                rv = 1;
+                break;
+            }
+            len = 0;
+        }
+    }
+    if (rv == 0 && passthru_write(pt->out, block, len) != 0)
+        rv = 1;
+done:
+    if (rv != 0)
+        perror("semi2tab2: write");
+    passthru_close(pt);
+    return rv;
+}
+
+const unsigned char *next_change(const struct translation *tr,
+                                 const unsigned char *p, const unsigned char *end)
+/*
+ * purpose: find the first byte in [p, end) that `tr' rewrites or drops
+ * returns: a pointer to it, or `end' if there is none
+ */
+{
+    const unsigned char *q;
+
+    if (tr->changes == 1) {
+        q = memchr(p, tr->from_char, end - p);
+        return q != NULL ? q : end;
+    }
+    while (p < end && tr->to[*p] == *p && tr->keep[*p])
+        p++;
+    return p;
+}
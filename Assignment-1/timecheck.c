@@ -0,0 +1,214 @@
+#define    _GNU_SOURCE
+#include    <string.h>
+#include    <unistd.h>
+#include    "linereader.h"
+#include    "parallel.h"
+#include    "passthru.h"
+#include    "timecheck.h"
+
+/*
+ * timecheck.c
+ *   purpose: TI=HH:MM validator, see timecheck.h
+ */
+
+#define    OUTSIZE    (1 << 16)
+#define    NODIGIT    64
+
+/* value of each digit, NODIGIT for anything else */
+static unsigned char digit[256];
+
+/*
+ * indexed by tens * 10 + units of two digit values: 1 if in range.
+ * NODIGIT in either place gives an index of at least 64, past every 1
+ */
+static unsigned char hour_ok[NODIGIT * 11 + 1];
+static unsigned char minute_ok[NODIGIT * 11 + 1];
+
+/* bytes that may follow the minutes: end of field or end of line */
+static unsigned char ends_time[256];
+
+struct outbuf {
+    int fd;
+    size_t len;
+    int error;
+    char buf[OUTSIZE];
+};
+
+static void init_tables(void);
+
+static void put_record(const char *, size_t, void *);
+
+static void append_record(const char *, size_t, void *);
+
+static size_t timecheck_chunk(const char *, size_t, char *, void *);
+
+static int flush(struct outbuf *);
+
+static void init_tables(void)
+/*
+ * purpose: fill the lookup tables the first time they are needed
+ */
+{
+    static int done = 0;
+    int c;
+
+    if (done)
+        return;
+    for (c = 0; c < 256; c++)
+        digit[c] = NODIGIT;
+    for (c = '0'; c <= '9'; c++)
+        digit[c] = (unsigned char) (c - '0');
+    for (c = 0; c < 24; c++)
+        hour_ok[c] = 1;
+    for (c = 0; c < 60; c++)
+        minute_ok[c] = 1;
+    ends_time[';'] = ends_time['\n'] = ends_time['\r'] = 1;
+    done = 1;
+}
+
+int time_ok(const char *p, const char *end)
+/*
+ * purpose: check that the value starting at `p' is exactly HH:MM
+ * returns: 1 if it is, 0 if not
+ *   notes: no branches on the digits; a non-digit counts as NODIGIT,
+ *          which lands every index it is part of past the tables' 1s
+ */
+{
+    const unsigned char *s = (const unsigned char *) p;
+    unsigned char tail;
+
+    init_tables();
+    if (end - p < 5)
+        return 0;
+    tail = end - p == 5 ? 1 : ends_time[s[5]];
+    return hour_ok[digit[s[0]] * 10 + digit[s[1]]]
+           & (s[2] == ':')
+           & minute_ok[digit[s[3]] * 10 + digit[s[4]]]
+           & tail;
+}
+
+size_t timecheck_block(const char *buf, size_t len,
+                       void (*fn)(const char *, size_t, void *), void *arg)
+/*
+ * purpose: run `fn' on every record in `buf' with a bad TI time
+ * returns: the number of bad records
+ *   notes: `buf' holds whole lines; the line passed to `fn' includes its
+ *          newline if it has one
+ */
+{
+    const char *end = buf + len, *p = buf, *hit, *line, *eol;
+    size_t bad = 0;
+
+    while ((hit = memmem(p, end - p, TIME_KEY, sizeof(TIME_KEY) - 1)) != NULL) {
+        /* TI= must start a field, not sit inside some value */
+        if (hit != buf && hit[-1] != ';' && hit[-1] != '\n') {
+            p = hit + 1;
+            continue;
+        }
+        if (hit == buf || hit[-1] == '\n') {
+            line = hit;
+        } else {
+            line = memrchr(buf, '\n', hit - buf);
+            line = line == NULL ? buf : line + 1;
+        }
+        eol = memchr(hit, '\n', end - hit);
+        eol = eol == NULL ? end : eol + 1;
+
+        if (!time_ok(hit + sizeof(TIME_KEY) - 1, eol)) {
+            fn(line, eol - line, arg);
+            bad++;
+        }
+        p = eol;    /* one TI per record */
+    }
+    return bad;
+}
+
+int timecheck_filter(int in, int out, int jobs)
+/*
+ * purpose: copy the records with bad times from `in' to `out', collecting
+ *          them in one output buffer that is written OUTSIZE at a time,
+ *          or with jobs > 1 in per-chunk buffers filled in parallel
+ * returns: 0 on success, 1 on a read or write error
+ */
+{
+    static struct outbuf ob;
+    struct line_reader lr;
+    const char *block;
+    size_t len;
+    int rv;
+
+    init_tables();      /* before any worker thread can race to do it */
+    if (jobs > 1)
+        return par_filter(in, out, jobs, 1, timecheck_chunk, NULL) < 0;
+
+    if (lr_init(&lr, in) != 0)
+        return 1;
+    ob.fd = out;
+    ob.len = 0;
+    ob.error = 0;
+
+    while (!ob.error && lr_block(&lr, &block, &len) != 0)
+        timecheck_block(block, len, put_record, &ob);
+
+    rv = flush(&ob) != 0 || ob.error || lr.error;
+    lr_free(&lr);
+    return rv;
+}
+
+static void put_record(const char *line, size_t len, void *arg)
+/*
+ * purpose: append one record to the output buffer, adding a newline if
+ *          it is the last line of the input and has none
+ */
+{
+    struct outbuf *ob = arg;
+
+    if (ob->len + len + 1 > OUTSIZE && flush(ob) != 0)
+        return;
+    if (len + 1 > OUTSIZE) {
+        if (passthru_write(ob->fd, line, len) != 0)
+            ob->error = 1;
+    } else {
+        memcpy(ob->buf + ob->len, line, len);
+        ob->len += len;
+    }
+    if (len > 0 && line[len - 1] != '\n')
+        ob->buf[ob->len++] = '\n';
+}
+
+static size_t timecheck_chunk(const char *in, size_t len, char *out, void *unused)
+/*
+ * purpose: par_fn for jobs > 1: copy the bad records of `in' to `out'
+ */
+{
+    char *end = out;
+
+    (void) unused;
+    timecheck_block(in, len, append_record, &end);
+    return end - out;
+}
+
+static void append_record(const char *line, size_t len, void *arg)
+/*
+ * purpose: append one record at *arg, which has room for it, and advance
+ */
+{
+    char **end = arg;
+
+    memcpy(*end, line, len);
+    *end += len;
+    if (len > 0 && line[len - 1] != '\n')
+        *(*end)++ = '\n';
+}
+
+static int flush(struct outbuf *ob)
+/*
+ * purpose: write out whatever is in the buffer
+ * returns: 0 on success, -1 on error
+ */
+{
+    if (ob->len > 0 && passthru_write(ob->fd, ob->buf, ob->len) != 0)
+        ob->error = 1;
+    ob->len = 0;
+    return ob->error ? -1 : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef TIMECHECK_H
+#define TIMECHECK_H
+
+#include    <stddef.h>
+
+/*
+ * timecheck.h
+ *   purpose: find schedule records whose TI field is not a valid HH:MM
+ *            time (00:00 to 23:59)
+ *     usage: timecheck_filter(0, 1, jobs) copies every bad record from stdin
+ *            to stdout, on `jobs' threads if more than one; timecheck_block()
+ *            does the same for one buffer of whole lines, handing each bad
+ *            record to a callback
+ *     notes: records without a TI field are not reported
+ */
+
+#define    TIME_KEY    "TI="
+
+int time_ok(const char *, const char *);
+
+size_t timecheck_block(const char *, size_t, void (*)(const char *, size_t, void *), void *);
+
+int timecheck_filter(int, int, int);
+
+#endif
@@ -1,25 +1,448 @@
+#include "ctype.h"
 #include "stdio.h"
+#include "string.h"
+#include "input.h"
+#include "passthru.h"
+#include "runs.h"
 
 /*
  * File: uniqc.c
  * Purpose: Get unique characters
  * Author: Bhavani Shekhawat
+ * Usage: uniqc [-z | -s | -c | -r | -d] < input > output
+ *        -z  when stdin is a regular file, leave runs of PASSTHRU_MIN or more
+ *            bytes without a repeat to the kernel (see passthru.h)
+ *        -s  drop the repeats instead of writing a NUL for each, so the
+ *            output is one byte per run (see runs.h)
+ *        -c  list the runs, one line each: the byte, a tab and how many
+ *            times it repeats. Bytes outside of isgraph are written as
+ *            \n, \t, \s (space), \\ or \xHH
+ *        -r  write the runs as an RLE container: the 4 bytes RLE_MAGIC, then
+ *            for every run its byte and its length as a varint (7 bits per
+ *            byte, low bits first, the top bit set on all but the last)
+ *        -d  decode an RLE container back to the original bytes
  */
 
-int main() {
+#define BLOCK_SIZE (1 << 17)
+#define RLE_MAGIC "RLE1"
+#define VARINT_MAX 10   // bytes in the varint of a 64-bit count
 
-    int curr;
-    int prev;
-    while ((curr = getchar()) != EOF) {
+int block_uniq(int in, int out);
 
-        if (curr == prev) {
+int splice_uniq(struct passthru *pt);
+
+int squeeze_uniq(int in, int out);
+
+int count_runs(int in, int out, int (*emit)(int out, int c, unsigned long long count));
+
+int list_run(int out, int c, unsigned long long count);
+
+int pack_run(int out, int c, unsigned long long count);
+
+int unpack_runs(int in, int out);
+
+int make_room(int out, size_t room);
+
+// The output of -c, -r and -d collects here, see make_room
+static unsigned char out_block[BLOCK_SIZE];
+static size_t out_len;
+
+int main(int argc, char *argv[]) {
+
+    struct passthru pt;
+
+    if (argc > 1 && strcmp(argv[1], "-z") == 0 && passthru_open(&pt, 0, 1) == 0) {
+        return splice_uniq(&pt);
+    }
+    if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        return squeeze_uniq(0, 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        return count_runs(0, 1, list_run);
+    }
+    if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+        memcpy(out_block, RLE_MAGIC, 4);
+        out_len = 4;
+        return count_runs(0, 1, pack_run);
+    }
+    if (argc > 1 && strcmp(argv[1], "-d") == 0) {
+        return unpack_runs(0, 1);
+    }
+
+    return block_uniq(0, 1);
+}
+
+/*
+ * Every byte that repeats the one before it becomes a NUL. The input is
+ * scanned in place (see input.h) and the output collected in one block;
+ * the previous byte carries over from one stretch of input to the next
+ */
+int block_uniq(int in, int out) {
+
+    static unsigned char block[BLOCK_SIZE];
+    struct input src;
+    const char *p;
+    size_t n;
+    size_t len = 0;
+    int prev = EOF;
+
+    if (in_open(&src, in) != 0) {
+        perror("uniqc");
+        return 1;
+    }
+
+    while (in_next(&src, &p, &n)) {
+        for (size_t i = 0; i < n; i++) {
+            int curr = (unsigned char) p[i];
+
+            block[len++] = curr == prev ? '\0' : curr;
             prev = curr;
-            putchar('\0');
+            if (len == BLOCK_SIZE) {
+                if (passthru_write(out, block, len) != 0) {
+                    perror("uniqc: write");
+                    return 1;
+                }
+                len = 0;
+            }
+        }
+    }
+
+    if (src.error) {
+        perror("uniqc: read");
+        return 1;
+    }
+    if (passthru_write(out, block, len) != 0) {
+        perror("uniqc: write");
+        return 1;
+    }
+    in_close(&src);
+    return 0;
+}
+
+/*
+ * Only the first byte of every run is written. The kernel appends to the
+ * block, which goes out once it is half full, so every call gets at least
+ * half a block of input
+ */
+int squeeze_uniq(int in, int out) {
+
+    static unsigned char block[BLOCK_SIZE + RUNS_SLACK];
+    struct input src;
+    const char *p;
+    size_t n;
+    size_t len = 0;
+    int prev = EOF;
+
+    if (in_open(&src, in) != 0) {
+        perror("uniqc");
+        return 1;
+    }
+
+    while (in_next(&src, &p, &n)) {
+        while (n > 0) {
+            size_t take = n < BLOCK_SIZE - len ? n : BLOCK_SIZE - len;
+
+            len += runs_squeeze((const unsigned char *) p, take, block + len, &prev);
+            p += take;
+            n -= take;
+            if (len >= BLOCK_SIZE / 2) {
+                if (passthru_write(out, block, len) != 0) {
+                    perror("uniqc: write");
+                    return 1;
+                }
+                len = 0;
+            }
+        }
+    }
+
+    if (src.error) {
+        perror("uniqc: read");
+        return 1;
+    }
+    if (passthru_write(out, block, len) != 0) {
+        perror("uniqc: write");
+        return 1;
+    }
+    in_close(&src);
+    return 0;
+}
+
+/*
+ * Find the runs of the input and hand each one to emit, once it is known
+ * where it ends. A run is measured with runs_length, so it goes by a vector
+ * at a time; one can go on from one stretch of input to the next
+ */
+int count_runs(int in, int out, int (*emit)(int out, int c, unsigned long long count)) {
+
+    struct input src;
+    const char *p;
+    size_t n;
+    int c = EOF;
+    unsigned long long count = 0;
+
+    if (in_open(&src, in) != 0) {
+        perror("uniqc");
+        return 1;
+    }
+
+    while (in_next(&src, &p, &n)) {
+        const unsigned char *s = (const unsigned char *) p;
+        size_t i = 0;
+
+        while (i < n) {
+            size_t run;
+
+            if (s[i] != c) {
+                if (count > 0 && emit(out, c, count) != 0) {
+                    perror("uniqc: write");
+                    return 1;
+                }
+                c = s[i];
+                count = 0;
+            }
+            // Most runs are a byte or two long, only a longer one is worth the vector search
+            run = 1;
+            while (run < 4 && i + run < n && s[i + run] == c) {
+                run++;
+            }
+            if (run == 4) {
+                run += runs_length(s + i + 4, n - i - 4, (unsigned char) c);
+            }
+            count += run;
+            i += run;
+        }
+    }
+
+    if (src.error) {
+        perror("uniqc: read");
+        return 1;
+    }
+    if ((count > 0 && emit(out, c, count) != 0) || passthru_write(out, out_block, out_len) != 0) {
+        perror("uniqc: write");
+        return 1;
+    }
+    in_close(&src);
+    return 0;
+}
+
+/*
+ * A run as a line of text for -c. There is one call per run, so the line
+ * is put together by hand rather than with printf
+ */
+int list_run(int out, int c, unsigned long long count) {
+
+    static const char hex[] = "0123456789abcdef";
+    unsigned char digits[20];
+    unsigned char *line;
+    int n = 0;
+
+    if (make_room(out, 32) != 0) {
+        return -1;
+    }
+    line = out_block + out_len;
+    if (isgraph(c) && c != '\\') {
+        *line++ = (unsigned char) c;
+    } else {
+        *line++ = '\\';
+        if (c == '\\' || c == ' ' || c == '\n' || c == '\t') {
+            *line++ = c == ' ' ? 's' : c == '\n' ? 'n' : c == '\t' ? 't' : '\\';
         } else {
-            putchar(curr);
-            prev = curr;
+            *line++ = 'x';
+            *line++ = hex[c >> 4];
+            *line++ = hex[c & 15];
+        }
+    }
+    *line++ = '\t';
+    do {
+        digits[n++] = (unsigned char) ('0' + count % 10);
+        count /= 10;
+    } while (count > 0);
+    while (n > 0) {
+        *line++ = digits[--n];
+    }
+    *line++ = '\n';
+    out_len = (size_t) (line - out_block);
+    return 0;
+}
+
+/*
+ * A run as its byte and a varint for -r
+ */
+int pack_run(int out, int c, unsigned long long count) {
+
+    if (make_room(out, 1 + VARINT_MAX) != 0) {
+        return -1;
+    }
+    out_block[out_len++] = (unsigned char) c;
+    while (count >= 0x80) {
+        out_block[out_len++] = (unsigned char) (count | 0x80);
+        count >>= 7;
+    }
+    out_block[out_len++] = (unsigned char) count;
+    return 0;
+}
+
+/*
+ * Expand an RLE container. It is read a byte at a time, so a run may be
+ * split anywhere between two stretches of input; the runs themselves are
+ * written with memset, a block at a time
+ */
+int unpack_runs(int in, int out) {
+
+    struct input src;
+    const char *p;
+    size_t n;
+    size_t magic = 0;           // bytes of RLE_MAGIC seen so far
+    int c = EOF;                // the byte of the run being read, EOF between runs
+    unsigned long long count = 0;
+    int shift = 0;
+
+    if (in_open(&src, in) != 0) {
+        perror("uniqc");
+        return 1;
+    }
+
+    while (in_next(&src, &p, &n)) {
+        for (size_t i = 0; i < n; i++) {
+            unsigned char b = (unsigned char) p[i];
+
+            if (magic < 4) {
+                if (b != (unsigned char) RLE_MAGIC[magic++]) {
+                    fprintf(stderr, "uniqc: not an RLE container\n");
+                    return 1;
+                }
+                continue;
+            }
+            if (c == EOF) {
+                c = b;
+                count = 0;
+                shift = 0;
+                continue;
+            }
+            // a count is at most 10 bytes, the last holding only bit 63
+            if (shift == 63 && b > 1) {
+                fprintf(stderr, "uniqc: bad run length\n");
+                return 1;
+            }
+            count |= (unsigned long long) (b & 0x7f) << shift;
+            shift += 7;
+            if (b & 0x80) {
+                continue;
+            }
+
+            while (count > 0) {
+                size_t take;
+
+                if (make_room(out, 1) != 0) {
+                    perror("uniqc: write");
+                    return 1;
+                }
+                take = BLOCK_SIZE - out_len;
+                if (take > count) {
+                    take = (size_t) count;
+                }
+                memset(out_block + out_len, c, take);
+                out_len += take;
+                count -= take;
+            }
+            c = EOF;
+        }
+    }
+
+    if (src.error) {
+        perror("uniqc: read");
+        return 1;
+    }
+    if (magic < 4 || c != EOF) {
+        fprintf(stderr, "uniqc: RLE container cut short\n");
+        return 1;
+    }
+    if (passthru_write(out, out_block, out_len) != 0) {
+        perror("uniqc: write");
+        return 1;
+    }
+    in_close(&src);
+    return 0;
+}
+
+/*
+ * Write out_block out if it has less than room bytes free
+ */
+int make_room(int out, size_t room) {
+
+    if (BLOCK_SIZE - out_len >= room) {
+        return 0;
+    }
+    if (passthru_write(out, out_block, out_len) != 0) {
+        return -1;
+    }
+    out_len = 0;
+    return 0;
+}
+
+/*
+ * Same output as the loop in main, but only the repeats are rewritten in
+ * user space; the long stretches between them go out through passthru_span
+ */
+int splice_uniq(struct passthru *pt) {
+
+    static unsigned char block[BLOCK_SIZE];
+    const unsigned char *in = pt->base;
+    size_t size = pt->size;
+    size_t len = 0;
+    size_t start = 0;   // first byte of the current run without repeats
+    size_t i;
+
+    for (i = 1; i <= size; i++) {
+
+        // Keep going until a repeat (or the end of the input) shows up
+        if (i < size && in[i] != in[i - 1]) {
+            continue;
+        }
+
+        if (i - start >= PASSTHRU_MIN) {
+            if (passthru_write(pt->out, block, len) != 0 || passthru_span(pt, start, i - start) != 0) {
+                perror("uniqc: write");
+                return 1;
+            }
+            len = 0;
+        } else {
+            while (start < i) {
+                size_t n = i - start;
+                if (n > BLOCK_SIZE - len) {
+                    n = BLOCK_SIZE - len;
+                }
+                memcpy(block + len, in + start, n);
+                len += n;
+                start += n;
+                if (len == BLOCK_SIZE) {
+                    if (passthru_write(pt->out, block, len) != 0) {
+                        perror("uniqc: write");
+                        return 1;
+                    }
+                    len = 0;
+                }
+            }
         }
+
+        // The repeat itself becomes a NUL
+        if (i < size) {
+            block[len++] = '\0';
+            if (len == BLOCK_SIZE) {
+                if (passthru_write(pt->out, block, len) != 0) {
+                    perror("uniqc: write");
+                    return 1;
+                }
+                len = 0;
+            }
+        }
+        start = i + 1;
     }
 
+    if (passthru_write(pt->out, block, len) != 0) {
+        perror("uniqc: write");
+        return 1;
+    }
+    passthru_close(pt);
     return 0;
 }
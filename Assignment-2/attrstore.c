@@ -0,0 +1,118 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Attribute lines in one arena, see attrstore.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "attrstore.h"
+
+#define ATTR_INITIAL_TEXT       1024
+#define ATTR_INITIAL_SPANS      16
+
+/**
+ * Start with an empty store; nothing is allocated until the first line comes in
+ * @param store
+ */
+void attr_init(struct attr_store *store) {
+    store->text = NULL;
+    store->len = 0;
+    store->cap = 0;
+    store->spans = NULL;
+    store->count = 0;
+    store->cap_spans = 0;
+}
+
+/**
+ * Append a line, growing the arena and the span array by doubling when they are full
+ * @param store
+ * @param line the attribute text, not including the '\n'
+ * @param len
+ * @return the index of the line, or -1 if there was no memory for it
+ */
+int attr_add(struct attr_store *store, const char *line, size_t len) {
+    char *p = attr_reserve(store, len);
+
+    if (p == NULL) {
+        return -1;
+    }
+    memcpy(p, line, len);
+    return attr_commit(store, len);
+}
+
+/**
+ * Make room for a line of at most max bytes, to be written in place and then added with attr_commit
+ * @param store
+ * @param max
+ * @return where to write the line, or NULL if there was no memory for it
+ */
+char *attr_reserve(struct attr_store *store, size_t max) {
+    if (store->len + max > store->cap || store->text == NULL) {
+        size_t cap = store->cap ? store->cap : ATTR_INITIAL_TEXT;
+        char *text;
+
+        while (cap < store->len + max) {
+            cap *= 2;
+        }
+        if ((text = realloc(store->text, cap)) == NULL) {
+            return NULL;
+        }
+        store->text = text;
+        store->cap = cap;
+    }
+    if (store->count == store->cap_spans) {
+        int cap = store->cap_spans ? 2 * store->cap_spans : ATTR_INITIAL_SPANS;
+        struct attr_span *spans = realloc(store->spans, cap * sizeof(*spans));
+
+        if (spans == NULL) {
+            return NULL;
+        }
+        store->spans = spans;
+        store->cap_spans = cap;
+    }
+    return store->text + store->len;
+}
+
+/**
+ * Add the line written at the pointer attr_reserve returned
+ * @param store
+ * @param len bytes actually written, no more than were reserved
+ * @return the index of the line
+ */
+int attr_commit(struct attr_store *store, size_t len) {
+    store->spans[store->count].off = store->len;
+    store->spans[store->count].len = len;
+    store->len += len;
+    return store->count++;
+}
+
+/**
+ * Look up a stored line
+ * @param store
+ * @param i index returned by attr_add, must be below store->count
+ * @param len set to the length of the line
+ * @return the start of the line; it is not '\0' terminated
+ */
+const char *attr_get(const struct attr_store *store, int i, size_t *len) {
+    *len = store->spans[i].len;
+    return store->text + store->spans[i].off;
+}
+
+/**
+ * Forget all the lines but keep the memory for the next block
+ * @param store
+ */
+void attr_clear(struct attr_store *store) {
+    store->len = 0;
+    store->count = 0;
+}
+
+/**
+ * Give the memory back
+ * @param store
+ */
+void attr_free(struct attr_store *store) {
+    free(store->text);
+    free(store->spans);
+    attr_init(store);
+}
@@ -0,0 +1,41 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Storage for the lines of an <attributes></attributes> block.
+ * Every line is appended to one growing string arena and remembered by its offset and length,
+ * so there is no limit on the number of lines and starting a new block is just a reset of two counters.
+ */
+
+#ifndef ATTRSTORE_H
+#define ATTRSTORE_H
+
+#include <stddef.h>
+
+struct attr_span {
+    size_t off;
+    size_t len;
+};
+
+struct attr_store {
+    char *text;                 // the lines, back to back, without their '\n'
+    size_t len;
+    size_t cap;
+    struct attr_span *spans;    // where each line is in text
+    int count;
+    int cap_spans;
+};
+
+void attr_init(struct attr_store *store);
+
+int attr_add(struct attr_store *store, const char *line, size_t len);
+
+char *attr_reserve(struct attr_store *store, size_t max);
+
+int attr_commit(struct attr_store *store, size_t len);
+
+const char *attr_get(const struct attr_store *store, int i, size_t *len);
+
+void attr_clear(struct attr_store *store);
+
+void attr_free(struct attr_store *store);
+
+#endif
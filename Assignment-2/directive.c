@@ -0,0 +1,132 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Directive tag scanner, see directive.h
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include "directive.h"
+
+#define MAX_STATES              96
+#define MAX_CLASSES             32
+
+static const char *const patterns[DIR_COUNT] = {
+        [DIR_NOPROCESS_START] = "<noprocess>",
+        [DIR_NOPROCESS_END] = "</noprocess>",
+        [DIR_ATTRIBUTES_START] = "<attributes>",
+        [DIR_ATTRIBUTES_END] = "</attributes>",
+        [DIR_DELIM] = "<delim value=",
+        [DIR_TABLE_START] = "<table",
+        [DIR_TABLE_END] = "</table>",
+};
+
+// The automaton. Bytes that appear in no tag share class 0, so a row of the table is only a few dozen entries.
+static uint8_t byte_class[256];
+static uint8_t next_state[MAX_STATES][MAX_CLASSES];
+static unsigned matches[MAX_STATES];        // the tags that end in each state, as directive bits
+static pthread_once_t built = PTHREAD_ONCE_INIT;
+
+static void build(void);
+
+/**
+ * Find every directive in a line
+ * @param line
+ * @param len
+ * @param dirs set to what was found
+ */
+void dir_scan(const char *line, size_t len, struct directives *dirs) {
+    const unsigned char *p = (const unsigned char *) line;
+    const unsigned char *end = p + len;
+    unsigned state = 0;
+
+    pthread_once(&built, build);
+    dirs->found = 0;
+
+    while (p < end) {
+        // Every tag starts with '<', so outside of one there is nothing to do until the next '<'
+        if (state == 0) {
+            p = memchr(p, '<', (size_t) (end - p));
+            if (p == NULL) {
+                break;
+            }
+        }
+        state = next_state[state][byte_class[*p++]];
+        if (matches[state] & ~dirs->found) {
+            unsigned fresh = matches[state] & ~dirs->found;
+
+            dirs->found |= fresh;
+            for (int d = 0; d < DIR_COUNT; d++) {
+                if (fresh >> d & 1u) {
+                    dirs->at[d] = (const char *) p - strlen(patterns[d]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Read the value of a <delim value=...> tag; it may be quoted, as in <delim value=";">
+ * @param tag where the tag starts, as found by dir_scan
+ * @return the delimiter, '\0' if there is none
+ */
+char dir_delim_value(const char *tag) {
+    const char *value = tag + strlen(patterns[DIR_DELIM]);
+
+    if ((*value == '"' || *value == '\'') && value[1] != '\0' && value[1] != *value) {
+        value++;
+    }
+    return *value == '\n' ? '\0' : *value;
+}
+
+/**
+ * Build the trie of all the tags, then fill in the failure transitions breadth first so that every
+ * state has a move for every byte class
+ */
+static void build(void) {
+    uint8_t fail[MAX_STATES];
+    uint8_t queue[MAX_STATES];
+    int classes = 1;
+    int states = 1;
+    int head = 0;
+    int tail = 0;
+
+    memset(next_state, 0, sizeof(next_state));
+    for (int d = 0; d < DIR_COUNT; d++) {
+        const unsigned char *s = (const unsigned char *) patterns[d];
+        unsigned state = 0;
+
+        for (; *s; s++) {
+            if (byte_class[*s] == 0) {
+                byte_class[*s] = (uint8_t) classes++;
+            }
+            if (next_state[state][byte_class[*s]] == 0) {
+                next_state[state][byte_class[*s]] = (uint8_t) states++;
+            }
+            state = next_state[state][byte_class[*s]];
+        }
+        matches[state] |= 1u << d;
+    }
+
+    for (int c = 0; c < classes; c++) {
+        uint8_t s = next_state[0][c];
+        if (s != 0) {
+            fail[s] = 0;
+            queue[tail++] = s;
+        }
+    }
+    while (head < tail) {
+        uint8_t state = queue[head++];
+
+        matches[state] |= matches[fail[state]];
+        for (int c = 0; c < classes; c++) {
+            uint8_t s = next_state[state][c];
+            if (s != 0) {
+                fail[s] = next_state[fail[state]][c];
+                queue[tail++] = s;
+            } else {
+                next_state[state][c] = next_state[fail[state]][c];
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Finds the directive tags of the converters' input (<noprocess>, <attributes>, <delim value=...> and the
+ * <table> tags inside <noprocess>) in a single pass over a line.
+ * All the tags are compiled into one Aho-Corasick automaton, so a line is read once however many tags are
+ * looked for, instead of once per strstr call.
+ */
+
+#ifndef DIRECTIVE_H
+#define DIRECTIVE_H
+
+#include <stddef.h>
+
+enum directive {
+    DIR_NOPROCESS_START,        // <noprocess>
+    DIR_NOPROCESS_END,          // </noprocess>
+    DIR_ATTRIBUTES_START,       // <attributes>
+    DIR_ATTRIBUTES_END,         // </attributes>
+    DIR_DELIM,                  // <delim value=
+    DIR_TABLE_START,            // <table
+    DIR_TABLE_END,              // </table>
+    DIR_COUNT
+};
+
+struct directives {
+    unsigned found;                 // bit d is set if directive d is in the line
+    const char *at[DIR_COUNT];      // where the first one of each starts, like strstr
+};
+
+#define DIR_HAS(dirs, d)        (((dirs)->found >> (d)) & 1u)
+
+void dir_scan(const char *line, size_t len, struct directives *dirs);
+
+char dir_delim_value(const char *tag);
+
+#endif
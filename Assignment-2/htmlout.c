@@ -0,0 +1,188 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Buffered HTML output, see htmlout.h
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include "htmlout.h"
+
+// Indentation is copied out of here instead of being printed one space at a time
+static const char spaces[HTML_MAX_INDENT + 1] =
+        "                                                                ";
+
+static void drain(struct html_out *out, const char *p, size_t len);
+
+/**
+ * Start with an empty buffer that drains to fd
+ * @param out
+ * @param fd
+ */
+void html_init(struct html_out *out, int fd) {
+    html_init_sink(out, html_fd_sink, &out->fd);
+    out->fd = fd;
+}
+
+/**
+ * Start with an empty buffer that drains to a callback
+ * @param out
+ * @param sink called with every full buffer, and by html_flush
+ * @param arg passed on to sink
+ */
+void html_init_sink(struct html_out *out, html_sink sink, void *arg) {
+    out->sink = sink;
+    out->arg = arg;
+    out->fd = -1;
+    out->error = 0;
+    out->depth = 0;
+    out->width = HTML_INDENT_WIDTH;
+    out->len = 0;
+}
+
+/**
+ * Append len bytes of s
+ * @param out
+ * @param s
+ * @param len
+ */
+void html_write(struct html_out *out, const char *s, size_t len) {
+    if (out->len + len > HTML_OUT_SIZE) {
+        html_flush(out);
+
+        // Too big to be worth buffering
+        if (len > HTML_OUT_SIZE) {
+            drain(out, s, len);
+            return;
+        }
+    }
+    memcpy(out->buf + out->len, s, len);
+    out->len += len;
+}
+
+/**
+ * Append a single character
+ * @param out
+ * @param c
+ */
+void html_char(struct html_out *out, char c) {
+    if (out->len == HTML_OUT_SIZE) {
+        html_flush(out);
+    }
+    out->buf[out->len++] = c;
+}
+
+/**
+ * Append the given number of spaces with a single copy
+ * @param out
+ * @param count refers to amount of indent wanted
+ */
+void html_indent(struct html_out *out, int count) {
+    while (count > HTML_MAX_INDENT) {
+        html_write(out, spaces, HTML_MAX_INDENT);
+        count -= HTML_MAX_INDENT;
+    }
+    if (count > 0) {
+        html_write(out, spaces, (size_t) count);
+    }
+}
+
+/**
+ * Choose between indented and compact output; indented is the default
+ * @param out
+ * @param compact non-zero to leave the indentation out
+ */
+void html_set_compact(struct html_out *out, int compact) {
+    out->width = compact ? 0 : HTML_INDENT_WIDTH;
+}
+
+/**
+ * Append s on a line indented to the current depth. s brings its own newline, if the line ends with it.
+ * @param out
+ * @param s
+ * @param len
+ */
+void html_line(struct html_out *out, const char *s, size_t len) {
+    size_t indent = (size_t) (out->depth * out->width);
+
+    // Usually both fit, and this is two copies
+    if (indent <= HTML_MAX_INDENT && out->len + indent + len <= HTML_OUT_SIZE) {
+        memcpy(out->buf + out->len, spaces, indent);
+        memcpy(out->buf + out->len + indent, s, len);
+        out->len += indent + len;
+        return;
+    }
+    html_indent(out, (int) indent);
+    html_write(out, s, len);
+}
+
+/**
+ * Append an opening tag as a line of its own, and nest the lines after it one level deeper
+ * @param out
+ * @param tag
+ * @param len
+ */
+void html_open(struct html_out *out, const char *tag, size_t len) {
+    html_line(out, tag, len);
+    out->depth++;
+}
+
+/**
+ * Come out one level and append the closing tag as a line of its own
+ * @param out
+ * @param tag
+ * @param len
+ */
+void html_close(struct html_out *out, const char *tag, size_t len) {
+    if (out->depth > 0) {
+        out->depth--;
+    }
+    html_line(out, tag, len);
+}
+
+/**
+ * Write out whatever is buffered
+ * @param out
+ * @return 0 on success, -1 if a write failed now or earlier
+ */
+int html_flush(struct html_out *out) {
+    drain(out, out->buf, out->len);
+    out->len = 0;
+    return out->error ? -1 : 0;
+}
+
+/**
+ * Pass bytes on to the sink; gives up for good after an error
+ * @param out
+ * @param p
+ * @param len
+ */
+static void drain(struct html_out *out, const char *p, size_t len) {
+    if (len > 0 && !out->error && out->sink(out->arg, p, len) != 0) {
+        out->error = 1;
+    }
+}
+
+/**
+ * The sink behind html_init: hand len bytes to write(), retrying short writes
+ * @param arg points to the file descriptor, an int
+ * @param p
+ * @param len
+ * @return 0, or -1 if write() failed
+ */
+int html_fd_sink(void *arg, const char *p, size_t len) {
+    int fd = *(const int *) arg;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
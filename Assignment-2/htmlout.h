@@ -0,0 +1,70 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Buffered HTML output for the table converters.
+ * Tags, indentation and cell text are appended to one large buffer that is handed to write(), or to a callback,
+ * when it fills, instead of going through a printf call per byte.
+ * The buffer also knows how deep the next line is nested: html_open and html_close write a tag on a line of its
+ * own and go one level in or out, html_line writes a line at the current level. The indentation in front of
+ * them is copied from a static run of spaces, and compact output leaves it out altogether.
+ */
+
+#ifndef HTMLOUT_H
+#define HTMLOUT_H
+
+#include <stddef.h>
+
+#define HTML_OUT_SIZE           (1 << 16)
+#define HTML_MAX_INDENT         64
+#define HTML_INDENT_WIDTH       4
+
+/**
+ * Where buffered output goes; returns 0, or -1 if the bytes could not be written
+ */
+typedef int (*html_sink)(void *arg, const char *buf, size_t len);
+
+struct html_out {
+    html_sink sink;
+    void *arg;
+    int fd;
+    int error;
+    int depth;          // nesting level of the next line
+    int width;          // spaces per level, 0 for compact output
+    size_t len;
+    char buf[HTML_OUT_SIZE];
+};
+
+/**
+ * Appends a string literal; its length is known at compile time
+ */
+#define html_literal(out, s)    html_write((out), (s), sizeof(s) - 1)
+
+/**
+ * The same for html_line, html_open and html_close
+ */
+#define html_line_literal(out, s)   html_line((out), (s), sizeof(s) - 1)
+#define html_open_literal(out, s)   html_open((out), (s), sizeof(s) - 1)
+#define html_close_literal(out, s)  html_close((out), (s), sizeof(s) - 1)
+
+void html_init(struct html_out *out, int fd);
+
+void html_init_sink(struct html_out *out, html_sink sink, void *arg);
+
+void html_write(struct html_out *out, const char *s, size_t len);
+
+void html_char(struct html_out *out, char c);
+
+void html_indent(struct html_out *out, int spaces);
+
+void html_set_compact(struct html_out *out, int compact);
+
+void html_line(struct html_out *out, const char *s, size_t len);
+
+void html_open(struct html_out *out, const char *tag, size_t len);
+
+void html_close(struct html_out *out, const char *tag, size_t len);
+
+int html_flush(struct html_out *out);
+
+int html_fd_sink(void *arg, const char *buf, size_t len);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Reentrant tokenizer, see spantok.h
+ */
+
+#include <string.h>
+#include "spantok.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define IS_DELIM(set, c)        (((set)->bits[(unsigned char) (c) >> 6] >> ((unsigned char) (c) & 63)) & 1)
+
+static const char *find_delim(const char *p, const char *end, const struct delim_set *set);
+
+static const char *skip_delims(const char *p, const char *end, const struct delim_set *set);
+
+#ifdef __SSE2__
+static unsigned delim_mask(const char *p, const struct delim_set *set);
+#endif
+
+/**
+ * Build a delimiter set
+ * @param set
+ * @param chars the delimiter bytes, repeats are fine
+ * @param n how many bytes are in chars
+ */
+void delim_init(struct delim_set *set, const char *chars, size_t n) {
+    memset(set, 0, sizeof(*set));
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char) chars[i];
+
+        if (IS_DELIM(set, c)) {
+            continue;
+        }
+        set->bits[c >> 6] |= (uint64_t) 1 << (c & 63);
+        if (set->count < DELIM_MAX_VECTOR) {
+            set->chars[set->count] = c;
+        }
+        set->count++;
+    }
+}
+
+/**
+ * Start splitting len bytes at s. The bytes are only read, and must stay put until the last cell is used.
+ * @param tok
+ * @param s
+ * @param len
+ */
+void tok_init(struct tokenizer *tok, const char *s, size_t len) {
+    tok->pos = s;
+    tok->end = s + len;
+}
+
+/**
+ * Find the next cell. The set may differ from call to call, as with strtok.
+ * @param tok
+ * @param set the bytes that separate cells
+ * @param cell set to the cell that was found
+ * @return 1 if there was a cell, 0 at the end of the line
+ */
+int tok_next(struct tokenizer *tok, const struct delim_set *set, struct span *cell) {
+    const char *start = skip_delims(tok->pos, tok->end, set);
+    const char *stop;
+
+    if (start == tok->end) {
+        tok->pos = tok->end;
+        return 0;
+    }
+    stop = find_delim(start + 1, tok->end, set);
+    cell->ptr = start;
+    cell->len = (size_t) (stop - start);
+
+    // The delimiter that ended the cell is used up, even if the next call looks for different ones
+    tok->pos = stop == tok->end ? stop : stop + 1;
+    return 1;
+}
+
+/**
+ * @return the first delimiter at or after p, or end if there is none
+ */
+static const char *find_delim(const char *p, const char *end, const struct delim_set *set) {
+    if (set->count == 1) {
+        const char *hit = memchr(p, set->chars[0], (size_t) (end - p));
+        return hit ? hit : end;
+    }
+#ifdef __SSE2__
+    if (set->count <= DELIM_MAX_VECTOR) {
+        for (; end - p >= 16; p += 16) {
+            unsigned mask = delim_mask(p, set);
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+    while (p < end && !IS_DELIM(set, *p)) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @return the first byte at or after p that is not a delimiter, or end if there is none
+ */
+static const char *skip_delims(const char *p, const char *end, const struct delim_set *set) {
+#ifdef __SSE2__
+    if (set->count <= DELIM_MAX_VECTOR) {
+        for (; end - p >= 16; p += 16) {
+            unsigned mask = ~delim_mask(p, set) & 0xffff;
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+    while (p < end && IS_DELIM(set, *p)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef __SSE2__
+/**
+ * Compare 16 bytes against every byte of a small set
+ * @return bit i set if p[i] is a delimiter
+ */
+static unsigned delim_mask(const char *p, const struct delim_set *set) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    __m128i hits = _mm_setzero_si128();
+
+    for (int i = 0; i < set->count; i++) {
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8((char) set->chars[i])));
+    }
+    return (unsigned) _mm_movemask_epi8(hits);
+}
+#endif
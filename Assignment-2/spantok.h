@@ -0,0 +1,40 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Splits a line into cells without touching it.
+ * Unlike strtok the state lives in the caller's struct tokenizer, so any number of lines can be split at once
+ * (in different threads too), and every cell comes back as a pointer and a length into the original line.
+ * Runs of delimiters count as one, and the delimiter that ends a cell is consumed, just like strtok.
+ */
+
+#ifndef SPANTOK_H
+#define SPANTOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DELIM_WHITESPACE        " \n\t\r"
+#define DELIM_MAX_VECTOR        4       // sets larger than this are searched a byte at a time
+
+struct span {
+    const char *ptr;
+    size_t len;
+};
+
+struct delim_set {
+    uint64_t bits[4];                           // bit c is set if byte c is a delimiter
+    unsigned char chars[DELIM_MAX_VECTOR];      // the same bytes, for comparing 16 at a time
+    int count;                                  // how many distinct bytes are in the set
+};
+
+struct tokenizer {
+    const char *pos;
+    const char *end;
+};
+
+void delim_init(struct delim_set *set, const char *chars, size_t n);
+
+void tok_init(struct tokenizer *tok, const char *s, size_t len);
+
+int tok_next(struct tokenizer *tok, const struct delim_set *set, struct span *cell);
+
+#endif
@@ -0,0 +1,714 @@
+/**
+ * Author: Bhavani Shekhawat
+ * The table converters as a library, see tt2ht.h
+ * Lines can be of any length. TT2HT_PLAIN streams: cells are written out as their bytes arrive, so a row may span
+ * any number of tt2ht_feed calls and nothing of it is kept. The other modes need the whole line to see which
+ * tags it holds, so they collect it in a buffer that grows to the longest line.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "attrstore.h"
+#include "directive.h"
+#include "input.h"
+#include "spantok.h"
+#include "tt2ht.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define LINE_INITIAL_SIZE       256
+#define ROW_DEPTH               2       // tt2ht2 and wtf rows are two levels in
+#define PLAIN_BLOCK             64      // bytes classified at once, one bit each
+#define SPACE_CHAR              ' '
+#define TAB_CHAR                '\t'
+#define NEWLINE_CHAR            '\n'
+
+#define IS_SPACE(c)             ((c) == SPACE_CHAR || (c) == TAB_CHAR || (c) == NEWLINE_CHAR)
+
+// Where TT2HT_MARKUP and TT2HT_DELIMITED are in the document
+enum section {
+    SECTION_OUTSIDE,            // before any tag, or right after an end tag
+    SECTION_TABLE,              // rows of table data
+    SECTION_NOPROCESS,          // inside <noprocess>, lines are copied out as they are
+    SECTION_ATTRIBUTES          // inside <attributes>, one line per column
+};
+
+// Where TT2HT_PLAIN is in the current row
+enum plain {
+    PLAIN_LINE_START,           // nothing of the line has been seen yet
+    PLAIN_SPACE,                // between cells
+    PLAIN_CELL                  // inside a cell, its <td> has been written
+};
+
+struct tt2ht {
+    enum tt2ht_mode mode;
+    struct html_out out;
+
+    // TT2HT_PLAIN
+    bool hasProcessed;
+    enum plain plain;
+
+    // The line being collected, '\0' terminated once it is complete
+    char *line;
+    size_t len;
+    size_t cap;
+
+    // TT2HT_MARKUP and TT2HT_DELIMITED
+    enum section section;
+    bool isTableStartDone;
+    bool isTableEndDone;
+    bool isDelimFound;
+    char delim_tag;
+    struct attr_store attributes;   // lines of the last <attributes> block
+    struct attr_store td_tags;      // the same lines as ready-made <td ...> tags, one per column
+    struct delim_set whitespace;    // what ends the first cell of a row
+    struct delim_set spaces;        // what ends the cells after it
+    struct delim_set delimiters;    // the <delim> value and the line end
+    struct attr_store table_start_tag;  // the <table ...> line of <noprocess>, if there was one
+    struct attr_store table_end_tag;    // the same for </table>
+};
+
+static void plain_feed(struct tt2ht *ctx, const char *p, size_t len);
+
+static uint64_t space_mask(const char *p, uint64_t *newlines);
+
+static int append_line(struct tt2ht *ctx, const char *bytes, size_t len);
+
+static void process_line(struct tt2ht *ctx);
+
+static void process_markup(struct tt2ht *ctx, size_t len);
+
+static void process_html_data(struct tt2ht *ctx, const struct directives *dirs);
+
+static void process_attribute_data(struct tt2ht *ctx);
+
+static void compile_td_tags(struct tt2ht *ctx);
+
+static void process_plain_text(struct tt2ht *ctx, size_t len);
+
+static bool is_row(const struct tt2ht *ctx, const struct directives *dirs);
+
+static void render_row(const struct tt2ht *ctx, struct html_out *out, const char *line, size_t len);
+
+static void start_table_tag(struct tt2ht *ctx);
+
+static void end_table_tag(struct tt2ht *ctx);
+
+static void write_tag(struct tt2ht *ctx, const struct attr_store *tag);
+
+/**
+ * Make a converter
+ * @param mode which of the programs to behave like
+ * @param sink receives the HTML, in pieces of up to HTML_OUT_SIZE bytes
+ * @param arg passed on to sink
+ * @return the converter, or NULL if there was no memory for it
+ */
+struct tt2ht *tt2ht_new(enum tt2ht_mode mode, html_sink sink, void *arg) {
+    struct tt2ht *ctx = calloc(1, sizeof(*ctx));
+
+    if (ctx == NULL) {
+        return NULL;
+    }
+    attr_init(&ctx->attributes);
+    attr_init(&ctx->td_tags);
+    attr_init(&ctx->table_start_tag);
+    attr_init(&ctx->table_end_tag);
+    delim_init(&ctx->whitespace, DELIM_WHITESPACE, strlen(DELIM_WHITESPACE));
+    delim_init(&ctx->spaces, " ", 1);
+    tt2ht_reset(ctx, mode, sink, arg);
+    return ctx;
+}
+
+/**
+ * Get a converter ready for a new document, as if it had just been made.
+ * Memory the line buffer and the stores have grown to is kept, so a reused converter does not allocate again.
+ * @param ctx
+ * @param mode
+ * @param sink
+ * @param arg
+ */
+void tt2ht_reset(struct tt2ht *ctx, enum tt2ht_mode mode, html_sink sink, void *arg) {
+    ctx->mode = mode;
+    html_init_sink(&ctx->out, sink, arg);
+    ctx->len = 0;
+    ctx->hasProcessed = false;
+    ctx->plain = PLAIN_LINE_START;
+    ctx->section = SECTION_OUTSIDE;
+    ctx->isTableStartDone = false;
+    ctx->isTableEndDone = false;
+    ctx->isDelimFound = false;
+    ctx->delim_tag = '\0';
+    attr_clear(&ctx->attributes);
+    attr_clear(&ctx->td_tags);
+    attr_clear(&ctx->table_start_tag);
+    attr_clear(&ctx->table_end_tag);
+}
+
+/**
+ * Leave the indentation out of the HTML, or put it back. A new or reset converter indents.
+ * @param ctx
+ * @param compact
+ */
+void tt2ht_set_compact(struct tt2ht *ctx, bool compact) {
+    html_set_compact(&ctx->out, compact);
+}
+
+/**
+ * Convert the next len bytes of the document. Lines may be split across calls anywhere.
+ * @param ctx
+ * @param bytes
+ * @param len
+ * @return 0, or -1 once the sink has failed or memory has run out
+ */
+int tt2ht_feed(struct tt2ht *ctx, const char *bytes, size_t len) {
+    if (ctx->mode == TT2HT_PLAIN) {
+        plain_feed(ctx, bytes, len);
+        return ctx->out.error ? -1 : 0;
+    }
+    while (len > 0 && !ctx->out.error) {
+        const char *nl = memchr(bytes, NEWLINE_CHAR, len);
+        size_t n = nl ? (size_t) (nl - bytes) + 1 : len;
+
+        if (append_line(ctx, bytes, n) != 0) {
+            ctx->out.error = 1;
+            break;
+        }
+        bytes += n;
+        len -= n;
+        if (nl) {
+            process_line(ctx);
+        }
+    }
+    return ctx->out.error ? -1 : 0;
+}
+
+/**
+ * End the document: finish a last line that has no newline, close the table and flush the output
+ * @param ctx
+ * @return 0, or -1 if any output could not be written
+ */
+int tt2ht_finish(struct tt2ht *ctx) {
+    if (ctx->mode == TT2HT_PLAIN) {
+        // A cell cut off by the end of the input is left open, as it always was
+        if (ctx->plain != PLAIN_LINE_START) {
+            html_close_literal(&ctx->out, "<tr/>\n");
+        }
+        html_close_literal(&ctx->out, "<table/>\n");     // Call this only once at the very end
+    } else {
+        if (ctx->len > 0) {
+            process_line(ctx);
+        }
+
+        // Close the table tags after plain-text data has been transformed
+        if (ctx->isTableStartDone && !ctx->isTableEndDone) {
+            end_table_tag(ctx);
+        }
+    }
+    return html_flush(&ctx->out);
+}
+
+/**
+ * Whether the converter is in the table body: the first row is out, no section is open and no partial line
+ * is pending, so the lines that follow can go to tt2ht_rows
+ * @param ctx
+ * @return true in the body
+ */
+bool tt2ht_in_body(const struct tt2ht *ctx) {
+    return ctx->mode != TT2HT_PLAIN && ctx->len == 0 && ctx->isTableStartDone
+           && (ctx->section == SECTION_OUTSIDE || ctx->section == SECTION_TABLE);
+}
+
+/**
+ * Render complete lines of the document body as rows without changing the converter, so the body can be split
+ * up and its parts rendered by several threads at once. Renders nothing unless tt2ht_in_body; stops before
+ * the first line that is not a row, which has to go through tt2ht_feed.
+ * @param ctx
+ * @param bytes lines that follow what was fed to ctx, or another part of the same body
+ * @param len
+ * @param out where the rows go, indented the way the converter would have
+ * @return how many bytes were rendered, always whole lines
+ */
+size_t tt2ht_rows(const struct tt2ht *ctx, const char *bytes, size_t len, struct html_out *out) {
+    const char *p = bytes;
+    const char *end = bytes + len;
+    const char *nl;
+
+    if (!tt2ht_in_body(ctx)) {
+        return 0;
+    }
+    out->depth = ctx->out.depth;
+    out->width = ctx->out.width;
+    while (p < end && (nl = memchr(p, NEWLINE_CHAR, (size_t) (end - p))) != NULL) {
+        size_t n = (size_t) (nl - p) + 1;
+        struct directives dirs;
+
+        dir_scan(p, n, &dirs);
+        if (!is_row(ctx, &dirs)) {
+            break;
+        }
+        render_row(ctx, out, p, n);
+        p += n;
+    }
+    return (size_t) (p - bytes);
+}
+
+/**
+ * Add HTML that was made elsewhere, such as by tt2ht_rows, after what the converter has written so far
+ * @param ctx
+ * @param html
+ * @param len
+ */
+void tt2ht_write(struct tt2ht *ctx, const char *html, size_t len) {
+    html_write(&ctx->out, html, len);
+}
+
+/**
+ * Free a converter
+ * @param ctx
+ */
+void tt2ht_free(struct tt2ht *ctx) {
+    if (ctx) {
+        attr_free(&ctx->attributes);
+        attr_free(&ctx->td_tags);
+        attr_free(&ctx->table_start_tag);
+        attr_free(&ctx->table_end_tag);
+        free(ctx->line);
+        free(ctx);
+    }
+}
+
+/**
+ * Convert everything that can be read from in, writing the HTML to out.
+ * A regular file is mapped and fed to the converter in place, see input.h.
+ * @param mode
+ * @param compact true to write the HTML without indentation
+ * @param in
+ * @param out
+ * @return 0 on success, 1 if reading, writing or allocating failed
+ */
+int tt2ht_run(enum tt2ht_mode mode, bool compact, int in, int out) {
+    struct tt2ht *ctx = tt2ht_new(mode, html_fd_sink, &out);
+    struct input src;
+    const char *bytes;
+    size_t len;
+    int status = 0;
+
+    if (ctx == NULL || in_open(&src, in) != 0) {
+        perror("tt2ht");
+        tt2ht_free(ctx);
+        return 1;
+    }
+    tt2ht_set_compact(ctx, compact);
+    while (in_next(&src, &bytes, &len)) {
+        if (tt2ht_feed(ctx, bytes, len) != 0) {
+            break;
+        }
+    }
+    if (src.error) {
+        perror("tt2ht: read");
+        status = 1;
+    }
+    if (tt2ht_finish(ctx) != 0) {
+        perror("tt2ht: write");
+        status = 1;
+    }
+    in_close(&src);
+    tt2ht_free(ctx);
+    return status;
+}
+
+/**
+ * TT2HT_PLAIN: write out the cells of the next len bytes, carrying on from wherever the last call stopped.
+ * Leading whitespace makes an empty first cell, every word becomes a cell, and a newline ends the row.
+ * The bytes are classified PLAIN_BLOCK at a time into bitmasks; the bits where a line or a word starts or
+ * ends are then visited in order, so runs of cell text and of spaces are passed over without a byte loop.
+ * @param ctx
+ * @param p
+ * @param len
+ */
+static void plain_feed(struct tt2ht *ctx, const char *p, size_t len) {
+    const char *end = p + len;
+    const char *cell = p;       // where the part of the current cell not written yet starts
+
+    while (p < end) {
+        size_t n = (size_t) (end - p) < PLAIN_BLOCK ? (size_t) (end - p) : PLAIN_BLOCK;
+        uint64_t valid = n == PLAIN_BLOCK ? ~(uint64_t) 0 : ((uint64_t) 1 << n) - 1;
+        uint64_t space, newline, word, after_word, after_newline;
+        uint64_t starts, ends, lines, events;
+
+        if (n == PLAIN_BLOCK) {
+            space = space_mask(p, &newline);
+        } else {
+            char tail[PLAIN_BLOCK] = {0};
+
+            memcpy(tail, p, n);
+            space = space_mask(tail, &newline);
+        }
+        space &= valid;
+        newline &= valid;
+        word = ~space & valid;
+
+        // Shift in what the byte before this block was, which the state remembers
+        after_word = word << 1 | (ctx->plain == PLAIN_CELL);
+        after_newline = newline << 1 | (ctx->plain == PLAIN_LINE_START);
+        starts = word & ~after_word;
+        ends = space & after_word;
+        lines = after_newline & valid;
+        events = starts | ends | newline | lines;
+
+        while (events) {
+            uint64_t bit = events & -events;
+            const char *at = p + __builtin_ctzll(events);
+
+            events &= events - 1;
+            if (lines & bit) {
+                if (!ctx->hasProcessed) {
+                    html_open_literal(&ctx->out, "<table>\n");
+                    ctx->hasProcessed = true;
+                }
+                html_open_literal(&ctx->out, "<tr>\n");
+                if (space & bit) {
+                    html_line_literal(&ctx->out, "<td><td/>\n");
+                }
+                ctx->plain = PLAIN_SPACE;
+            }
+            if (ends & bit) {
+                html_write(&ctx->out, cell, (size_t) (at - cell));
+                html_literal(&ctx->out, "<td/>\n");
+                ctx->plain = PLAIN_SPACE;
+            }
+            if (newline & bit) {
+                html_close_literal(&ctx->out, "<tr/>\n");
+                ctx->plain = PLAIN_LINE_START;
+            }
+            if (starts & bit) {
+                html_line_literal(&ctx->out, "<td>");
+                cell = at;
+                ctx->plain = PLAIN_CELL;
+            }
+        }
+        p += n;
+    }
+
+    // The cell may go on in the next buffer
+    if (ctx->plain == PLAIN_CELL) {
+        html_write(&ctx->out, cell, (size_t) (end - cell));
+    }
+}
+
+/**
+ * Classify PLAIN_BLOCK bytes
+ * @param p
+ * @param newlines set to the mask of the newlines
+ * @return the mask of the spaces, tabs and newlines; bit i is p[i]
+ */
+static uint64_t space_mask(const char *p, uint64_t *newlines) {
+    uint64_t space = 0;
+    uint64_t newline = 0;
+
+#ifdef __AVX2__
+    for (int i = 0; i < PLAIN_BLOCK; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+        __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(NEWLINE_CHAR));
+        __m256i sp = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(SPACE_CHAR)),
+                                     _mm256_cmpeq_epi8(v, _mm256_set1_epi8(TAB_CHAR)));
+
+        space |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(sp, nl)) << i;
+        newline |= (uint64_t) (uint32_t) _mm256_movemask_epi8(nl) << i;
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < PLAIN_BLOCK; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+        __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8(NEWLINE_CHAR));
+        __m128i sp = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(SPACE_CHAR)),
+                                  _mm_cmpeq_epi8(v, _mm_set1_epi8(TAB_CHAR)));
+
+        space |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_or_si128(sp, nl)) << i;
+        newline |= (uint64_t) (uint32_t) _mm_movemask_epi8(nl) << i;
+    }
+#else
+    for (int i = 0; i < PLAIN_BLOCK; i++) {
+        space |= (uint64_t) IS_SPACE(p[i]) << i;
+        newline |= (uint64_t) (p[i] == NEWLINE_CHAR) << i;
+    }
+#endif
+    *newlines = newline;
+    return space;
+}
+
+/**
+ * Add bytes to the line being collected, doubling its buffer when it is full
+ * @param ctx
+ * @param bytes
+ * @param len
+ * @return 0, or -1 if there was no memory
+ */
+static int append_line(struct tt2ht *ctx, const char *bytes, size_t len) {
+    if (ctx->len + len + 1 > ctx->cap) {
+        size_t cap = ctx->cap ? ctx->cap : LINE_INITIAL_SIZE;
+        char *line;
+
+        while (cap < ctx->len + len + 1) {
+            cap *= 2;
+        }
+        if ((line = realloc(ctx->line, cap)) == NULL) {
+            return -1;
+        }
+        ctx->line = line;
+        ctx->cap = cap;
+    }
+    memcpy(ctx->line + ctx->len, bytes, len);
+    ctx->len += len;
+    return 0;
+}
+
+/**
+ * TT2HT_MARKUP and TT2HT_DELIMITED: convert the collected line and start a new one
+ * @param ctx
+ */
+static void process_line(struct tt2ht *ctx) {
+    size_t len = ctx->len;
+
+    ctx->line[len] = '\0';
+    ctx->len = 0;
+    process_markup(ctx, len);
+}
+
+/**
+ * TT2HT_MARKUP and TT2HT_DELIMITED: find the tags in the line in one pass, then move between sections.
+ * A start tag opens a section (tags inside it are not looked at) and any end tag closes it;
+ * the line a start tag is on is not shown. Everything outside the sections is table data.
+ * @param ctx
+ * @param len length of the line
+ */
+static void process_markup(struct tt2ht *ctx, size_t len) {
+    struct directives dirs;
+
+    dir_scan(ctx->line, len, &dirs);
+
+    // The first <delim value=...> only picks the cell separator; it is not shown wherever it is
+    if (ctx->mode == TT2HT_DELIMITED && !ctx->isDelimFound && DIR_HAS(&dirs, DIR_DELIM)) {
+        char set[] = {dir_delim_value(dirs.at[DIR_DELIM]), '\n', '\r'};
+
+        ctx->isDelimFound = true;
+        ctx->delim_tag = set[0];
+        delim_init(&ctx->delimiters, set, sizeof(set));
+        return;
+    }
+
+    if (ctx->section == SECTION_OUTSIDE || ctx->section == SECTION_TABLE) {
+        if (DIR_HAS(&dirs, DIR_NOPROCESS_START)) {
+            ctx->section = SECTION_NOPROCESS;
+        } else if (DIR_HAS(&dirs, DIR_ATTRIBUTES_START)) {
+            attr_clear(&ctx->attributes);
+            ctx->section = SECTION_ATTRIBUTES;
+        } else {
+            ctx->section = SECTION_TABLE;
+            process_plain_text(ctx, len);
+        }
+        return;
+    }
+
+    if (DIR_HAS(&dirs, DIR_NOPROCESS_END) || DIR_HAS(&dirs, DIR_ATTRIBUTES_END)) {
+        if (ctx->section == SECTION_ATTRIBUTES) {
+            compile_td_tags(ctx);      // The block is complete, so the cell tags can be built once for all rows
+        }
+        ctx->section = SECTION_OUTSIDE;
+        return;
+    }
+
+    switch (ctx->section) {
+        case SECTION_NOPROCESS:
+            process_html_data(ctx, &dirs);
+            break;
+        case SECTION_ATTRIBUTES:
+            process_attribute_data(ctx);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Process the data from <noprocess> section
+ * @param ctx
+ * @param dirs the tags in the line
+ */
+static void process_html_data(struct tt2ht *ctx, const struct directives *dirs) {
+    const char *line = ctx->line;
+    bool has_table_start = DIR_HAS(dirs, DIR_TABLE_START);  // Check if <noprocess> contains any of the table tags
+    bool has_table_end = DIR_HAS(dirs, DIR_TABLE_END);      // Check for </table> tags as well
+
+    // Check if <table> was found; the last one wins
+    if (has_table_start) {
+        attr_clear(&ctx->table_start_tag);
+        if (attr_add(&ctx->table_start_tag, line, strcspn(line, "\n")) < 0) {
+            ctx->out.error = 1;
+        }
+    }
+
+    // Check if </table> was found
+    if (has_table_end) {
+        attr_clear(&ctx->table_end_tag);
+        if (attr_add(&ctx->table_end_tag, line, strcspn(line, "\n")) < 0) {
+            ctx->out.error = 1;
+        }
+    }
+
+    // Check if both were not found
+    if (!has_table_start && !has_table_end) {
+        html_write(&ctx->out, line, strcspn(line, "\n"));
+    }
+    if (!has_table_end) {
+        html_char(&ctx->out, NEWLINE_CHAR);
+    }
+}
+
+/**
+ * Parse the content under <attributes></attributes>
+ * @param ctx
+ */
+static void process_attribute_data(struct tt2ht *ctx) {
+    // Only the text up to the end of the line is kept; an empty line is kept too, as an empty attribute
+    if (attr_add(&ctx->attributes, ctx->line, strcspn(ctx->line, "\n")) < 0) {
+        ctx->out.error = 1;
+    }
+}
+
+/**
+ * Turn every stored attribute line into the <td ...> tag that opens its column, spaces removed
+ * @param ctx
+ */
+static void compile_td_tags(struct tt2ht *ctx) {
+    attr_clear(&ctx->td_tags);
+    for (int i = 0; i < ctx->attributes.count; i++) {
+        size_t len;
+        const char *attribute = attr_get(&ctx->attributes, i, &len);
+        char *tag = attr_reserve(&ctx->td_tags, len + 5);
+        size_t n = 4;
+
+        if (tag == NULL) {
+            ctx->out.error = 1;
+            return;
+        }
+        memcpy(tag, "<td ", 4);
+        for (size_t j = 0; j < len; j++) {
+            if (attribute[j] != ' ') {
+                tag[n++] = attribute[j];
+            }
+        }
+        tag[n++] = '>';
+        attr_commit(&ctx->td_tags, n);
+    }
+}
+
+/**
+ * Process the plain text to table data
+ * @param ctx
+ * @param len length of the line
+ */
+static void process_plain_text(struct tt2ht *ctx, size_t len) {
+    if (!ctx->isTableStartDone) {
+        start_table_tag(ctx);
+    }
+    render_row(ctx, &ctx->out, ctx->line, len);
+}
+
+/**
+ * Whether a line outside of the sections is a row, rather than a tag that changes how the lines after it
+ * are read. Only the first <delim value=...> is a tag; later ones are table data like anything else.
+ * @param ctx
+ * @param dirs the tags in the line
+ * @return true for a row
+ */
+static bool is_row(const struct tt2ht *ctx, const struct directives *dirs) {
+    if (DIR_HAS(dirs, DIR_NOPROCESS_START) || DIR_HAS(dirs, DIR_ATTRIBUTES_START)) {
+        return false;
+    }
+    return !(ctx->mode == TT2HT_DELIMITED && !ctx->isDelimFound && DIR_HAS(dirs, DIR_DELIM));
+}
+
+/**
+ * Write one line as a table row. Only reads the converter, so several threads can render rows at once.
+ * @param ctx
+ * @param out where the row goes
+ * @param line
+ * @param len length of the line; a '\0' in it ends it early
+ */
+static void render_row(const struct tt2ht *ctx, struct html_out *out, const char *line, size_t len) {
+    struct tokenizer tok;
+    struct span token;
+    bool delimited = ctx->mode == TT2HT_DELIMITED && ctx->delim_tag != '\0';
+    bool deeper = ctx->attributes.count > 0 && ctx->mode == TT2HT_MARKUP;
+    int column = 0;     // which of the <td ...> tags is next
+    int found;
+
+    tok_init(&tok, line, strnlen(line, len));
+    found = tok_next(&tok, delimited ? &ctx->delimiters : &ctx->whitespace, &token);
+    html_open_literal(out, "<tr>\n");
+
+    // tt2ht2 puts the cells one level further in once there are attributes
+    out->depth += deeper;
+    while (found) {
+        // Use the tag of this column, if there is one
+        if (ctx->attributes.count > 0 && column < ctx->td_tags.count) {
+            size_t n;
+            const char *tag = attr_get(&ctx->td_tags, column, &n);
+
+            html_line(out, tag, n);
+            column++;
+        } else {
+            html_line_literal(out, "<td>");
+        }
+        html_write(out, token.ptr, token.len);
+        html_literal(out, "</td>\n");
+
+        // If delimiter available, else work with space
+        found = tok_next(&tok, delimited ? &ctx->delimiters : &ctx->spaces, &token);
+    }
+    out->depth -= deeper;
+    html_close_literal(out, "<tr/>\n");
+}
+
+/**
+ * Start table tags
+ * @param ctx
+ */
+static void start_table_tag(struct tt2ht *ctx) {
+    write_tag(ctx, &ctx->table_start_tag);
+    html_char(&ctx->out, NEWLINE_CHAR);
+    ctx->out.depth = ROW_DEPTH;
+    ctx->isTableStartDone = true;
+}
+
+/**
+ * End table tags
+ * @param ctx
+ */
+static void end_table_tag(struct tt2ht *ctx) {
+    write_tag(ctx, &ctx->table_end_tag);
+    html_char(&ctx->out, NEWLINE_CHAR);
+    ctx->out.depth = 0;
+    ctx->isTableEndDone = true;
+}
+
+/**
+ * Write the stored table tag line, if <noprocess> had one
+ * @param ctx
+ * @param tag
+ */
+static void write_tag(struct tt2ht *ctx, const struct attr_store *tag) {
+    if (tag->count > 0) {
+        size_t len;
+        const char *text = attr_get(tag, 0, &len);
+
+        html_write(&ctx->out, text, len);
+    }
+}
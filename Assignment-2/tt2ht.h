@@ -0,0 +1,48 @@
+/**
+ * Author: Bhavani Shekhawat
+ * The table converters as a library.
+ * All the state of a conversion lives in a struct tt2ht, so one process can convert any number of documents,
+ * one after another or side by side. Input is pushed in with tt2ht_feed in pieces of any size, and the HTML
+ * comes out through a callback. tt2ht1, tt2ht2 and wtf are thin wrappers around tt2ht_run.
+ * Past the tags at its top, a tt2ht2 or wtf document is rows that do not depend on each other, so
+ * tt2ht_run_parallel hands the body out to a pool of threads with tt2ht_rows.
+ */
+
+#ifndef TT2HT_H
+#define TT2HT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "htmlout.h"
+
+enum tt2ht_mode {
+    TT2HT_PLAIN,        // tt2ht1: every line is a row, cells are separated by spaces or tabs
+    TT2HT_MARKUP,       // tt2ht2: <noprocess> and <attributes> sections, then rows
+    TT2HT_DELIMITED     // wtf: the same, and a <delim value=...> line picks the cell separator
+};
+
+struct tt2ht;
+
+struct tt2ht *tt2ht_new(enum tt2ht_mode mode, html_sink sink, void *arg);
+
+void tt2ht_reset(struct tt2ht *ctx, enum tt2ht_mode mode, html_sink sink, void *arg);
+
+void tt2ht_set_compact(struct tt2ht *ctx, bool compact);
+
+int tt2ht_feed(struct tt2ht *ctx, const char *bytes, size_t len);
+
+int tt2ht_finish(struct tt2ht *ctx);
+
+void tt2ht_free(struct tt2ht *ctx);
+
+bool tt2ht_in_body(const struct tt2ht *ctx);
+
+size_t tt2ht_rows(const struct tt2ht *ctx, const char *bytes, size_t len, struct html_out *out);
+
+void tt2ht_write(struct tt2ht *ctx, const char *html, size_t len);
+
+int tt2ht_run(enum tt2ht_mode mode, bool compact, int in, int out);
+
+int tt2ht_run_parallel(enum tt2ht_mode mode, bool compact, int in, int out, int workers);
+
+#endif
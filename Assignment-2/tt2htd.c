@@ -0,0 +1,278 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Purpose: Serves table conversions over a Unix socket, so a front end does not have to start tt2ht1, tt2ht2
+ * or wtf once per page.
+ * Usage: tt2htd [-j workers] socket-path
+ * Each worker thread owns one converter that is reset, not rebuilt, between documents, and takes connections
+ * from the shared socket one at a time. A connection may send any number of documents, one after another:
+ *   request:  one byte for the converter ('1' = tt2ht1, '2' = tt2ht2, 'w' = wtf), then the document as
+ *             chunks of a 4-byte big-endian length and that many bytes, ended by a chunk of length 0
+ *   response: the HTML as chunks in the same framing, ended by a chunk of length 0
+ * The HTML is sent while the document is still coming in, so a client has to read the response as it writes.
+ * An unknown converter byte, a broken chunk or a failed write closes the connection, and so does a client that
+ * sends nothing or takes none of the response for IO_TIMEOUT seconds, between documents as well as inside one,
+ * so a few idle or stuck clients cannot tie up every worker.
+ * A socket left at socket-path by an earlier run is replaced; any other kind of file there is an error.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "tt2ht.h"
+
+#define DEFAULT_WORKERS         4
+#define MAX_WORKERS             256
+#define CHUNK_SIZE              (1 << 16)
+#define IO_TIMEOUT              30     // seconds a read or write on a connection may block
+
+struct worker {
+    pthread_t thread;
+    int listener;
+    int conn;                   // the connection being served, the sink writes its chunks here
+    struct tt2ht *ctx;          // kept warm from one document to the next
+    char buf[CHUNK_SIZE];
+};
+
+static void *serve(void *arg);
+
+static int convert(struct worker *w, enum tt2ht_mode mode);
+
+static int send_chunk(void *arg, const char *buf, size_t len);
+
+static int read_full(int fd, void *buf, size_t len);
+
+static int write_full(int fd, struct iovec *iov, int count);
+    struct sockaddr_un addr;
+    struct stat st;
+int main(int argc, char *argv[]) {
+    struct sockaddr_un addr;
+    struct worker *workers;
+    int count = DEFAULT_WORKERS;
+    int listener;
+    const char *path;
+
+    if (argc == 4 && strcmp(argv[1], "-j") == 0) {
+        count = atoi(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 2 || count < 1 || count > MAX_WORKERS) {
+        fprintf(stderr, "usage: tt2htd [-j workers] socket-path\n");
+        return 2;
+    }
+    path = argv[1];
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "tt2htd: socket path too long\n");
+        return 2;
+    }
+
+    // A client that goes away should only end its own connection
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    // Only ever remove a stale socket, never a file the path was given by mistake
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "tt2htd: %s exists and is not a socket\n", path);
+            return 1;
+        }
+        if (unlink(path) != 0) {
+            perror(path);
+            return 1;
+        }
+    } else if (errno != ENOENT) {
+        perror(path);
+        return 1;
+    }
+    if ((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+        || bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0
+        || listen(listener, SOMAXCONN) != 0) {
+        perror(path);
+        return 1;
+    }
+
+    if ((workers = calloc((size_t) count, sizeof(*workers))) == NULL) {
+        perror("tt2htd");
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        workers[i].listener = listener;
+        workers[i].conn = -1;
+        workers[i].ctx = tt2ht_new(TT2HT_PLAIN, send_chunk, &workers[i]);
+        if (workers[i].ctx == NULL || pthread_create(&workers[i].thread, NULL, serve, &workers[i]) != 0) {
+            perror("tt2htd");
+            return 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    return 0;
+}
+
+/**
+ * A worker: take a connection, convert documents until the client is done, repeat
+ * @param arg the struct worker
+ * @return NULL
+ */
+static void *serve(void *arg) {
+    struct worker *w = arg;
+
+    struct timeval timeout = {IO_TIMEOUT, 0};
+
+    for (;;) {
+        unsigned char kind;
+        enum tt2ht_mode mode;
+
+        if ((w->conn = accept(w->listener, NULL, NULL)) < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("tt2htd: accept");
+            return NULL;
+        }
+
+        // A blocked read or write then fails with EAGAIN, which drops the connection
+        if (setsockopt(w->conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0
+            || setsockopt(w->conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+            perror("tt2htd: timeout");
+            close(w->conn);
+            w->conn = -1;
+            continue;
+        }
+        while (read_full(w->conn, &kind, 1) == 0) {
+            if (kind == '1') {
+                mode = TT2HT_PLAIN;
+            } else if (kind == '2') {
+                mode = TT2HT_MARKUP;
+            } else if (kind == 'w') {
+                mode = TT2HT_DELIMITED;
+            } else {
+                break;
+            }
+            if (convert(w, mode) != 0) {
+                break;
+            }
+        }
+        close(w->conn);
+        w->conn = -1;
+    }
+}
+
+/**
+ * Convert one document from the connection, answering as it goes
+ * @param w
+ * @param mode
+ * @return 0, or -1 if the connection should be dropped
+ */
+static int convert(struct worker *w, enum tt2ht_mode mode) {
+    uint32_t size;
+    int status = 0;
+
+    tt2ht_reset(w->ctx, mode, send_chunk, w);
+    for (;;) {
+        if (read_full(w->conn, &size, sizeof(size)) != 0) {
+            return -1;
+        }
+        size = ntohl(size);
+        if (size == 0) {
+            break;
+        }
+
+        // Keep reading to the end of the document even after the output failed, so the framing holds
+        while (size > 0) {
+            size_t n = size < CHUNK_SIZE ? size : CHUNK_SIZE;
+
+            if (read_full(w->conn, w->buf, n) != 0) {
+                return -1;
+            }
+            if (status == 0) {
+                status = tt2ht_feed(w->ctx, w->buf, n);
+            }
+            size -= (uint32_t) n;
+        }
+    }
+    if (status != 0 || tt2ht_finish(w->ctx) != 0) {
+        return -1;
+    }
+    return send_chunk(w, NULL, 0);
+}
+
+/**
+ * The converter's sink: send the HTML as one chunk
+ * @param arg the struct worker
+ * @param buf
+ * @param len 0 for the chunk that ends a response
+ * @return 0, or -1 if the client could not be written to
+ */
+static int send_chunk(void *arg, const char *buf, size_t len) {
+    const struct worker *w = arg;
+    uint32_t size = htonl((uint32_t) len);
+    struct iovec iov[2];
+
+    iov[0].iov_base = &size;
+    iov[0].iov_len = sizeof(size);
+    iov[1].iov_base = (void *) buf;
+    iov[1].iov_len = len;
+    return write_full(w->conn, iov, len > 0 ? 2 : 1);
+}
+
+/**
+ * Read exactly len bytes
+ * @return 0, or -1 on an error, a timeout or if the connection ended first
+ */
+static int read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= (size_t) n;
+    }
+    return 0;
+}
+
+/**
+ * Write all of the buffers, continuing after short writes
+ * @return 0, or -1 on an error or a timeout
+ */
+static int write_full(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        while (count > 0 && (size_t) n >= iov->iov_len) {
+            n -= (ssize_t) iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= (size_t) n;
+        }
+    }
+    return 0;
+}
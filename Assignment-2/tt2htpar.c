@@ -0,0 +1,373 @@
+/**
+ * Author: Bhavani Shekhawat
+ * Converts a tt2ht2 or wtf document on several threads, see tt2ht.h
+ * The input is taken in rounds of one part per worker, straight from the mapping when it is a regular file.
+ * Lines go through the converter one at a time until it is in the table body; from there the round is cut at
+ * newlines into parts, every part is rendered by a worker into its own buffer, and the buffers are written out
+ * in input order. A tag inside a part ends the round there and the converter takes over again, so the HTML is
+ * the same as tt2ht_run would make.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "input.h"
+#include "tt2ht.h"
+
+#define MAX_WORKERS             256
+#define PART_SIZE               (4 << 20)       // input per worker per round
+#define MIN_PART_SIZE           (64 << 10)      // less than this is not worth handing to another thread
+#define HTML_INITIAL_SIZE       (1 << 20)
+
+// A piece of the body and the HTML made from it
+struct part {
+    const char *bytes;
+    size_t len;
+    size_t done;                // how much of it was rows
+    char *html;
+    size_t html_len;
+    size_t html_cap;
+    struct html_out out;
+};
+
+struct pool {
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // a round has been handed out
+    pthread_cond_t done;        // the last part of the round is rendered
+    const struct tt2ht *ctx;
+    struct part *parts;
+    int workers;
+    int count;                  // parts in the round
+    int next;                   // the first part nobody has taken yet
+    int pending;                // parts not rendered yet
+    bool quit;
+};
+
+static int fill(int fd, char *buf, size_t cap, size_t *have, bool *eof);
+
+static int convert(struct pool *pool, struct tt2ht *ctx, const char *buf, size_t len, size_t *used);
+
+static int render_body(struct pool *pool, struct tt2ht *ctx, const char *body, size_t len, size_t *done);
+
+static void *work(void *arg);
+
+static int part_sink(void *arg, const char *buf, size_t len);
+
+/**
+ * Convert everything that can be read from in, writing the HTML to out, with the rows rendered by
+ * several threads
+ * @param mode TT2HT_MARKUP or TT2HT_DELIMITED; tt2ht1's rows are written as they are read already
+ * @param compact true to write the HTML without indentation
+ * @param in
+ * @param out
+ * @param workers how many threads render rows, up to MAX_WORKERS; 1 or less is the same as tt2ht_run
+ * @return 0 on success, 1 if reading, writing or allocating failed
+ */
+int tt2ht_run_parallel(enum tt2ht_mode mode, bool compact, int in, int out, int workers) {
+    struct pool pool;
+    struct input src;
+    struct tt2ht *ctx;
+    pthread_t *threads;
+    size_t cap;
+    size_t have = 0;
+    bool eof = false;
+    int started = 0;
+    int status = 0;
+    char *buf = NULL;
+
+    if (workers <= 1 || mode == TT2HT_PLAIN) {
+        return tt2ht_run(mode, compact, in, out);
+    }
+    if (workers > MAX_WORKERS) {
+        workers = MAX_WORKERS;
+    }
+
+    // A round is taken from the mapping if there is one, else read into buf
+    cap = (size_t) workers * PART_SIZE;
+    if (in_map(&src, in) != 0) {
+        buf = malloc(cap);
+    }
+    ctx = tt2ht_new(mode, html_fd_sink, &out);
+    threads = calloc((size_t) workers, sizeof(*threads));
+    memset(&pool, 0, sizeof(pool));
+    pool.parts = calloc((size_t) workers, sizeof(*pool.parts));
+    pool.ctx = ctx;
+    pool.workers = workers;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.start, NULL);
+    pthread_cond_init(&pool.done, NULL);
+    if (ctx == NULL || (src.base == NULL && buf == NULL) || threads == NULL || pool.parts == NULL) {
+        perror("tt2ht");
+        status = 1;
+    } else {
+        tt2ht_set_compact(ctx, compact);
+    }
+    for (; status == 0 && started < workers; started++) {
+        if ((errno = pthread_create(&threads[started], NULL, work, &pool)) != 0) {
+            perror("tt2ht: threads");
+            status = 1;
+            break;
+        }
+    }
+
+    while (status == 0 && !eof) {
+        const char *round;
+        size_t used;
+
+        if (src.base != NULL) {
+            round = src.base + src.off;
+            have = src.size - src.off < cap ? src.size - src.off : cap;
+            eof = src.off + have == src.size;
+        } else if (fill(in, buf, cap, &have, &eof) == 0) {
+            round = buf;
+        } else {
+            perror("tt2ht: read");
+            status = 1;
+            break;
+        }
+        if (convert(&pool, ctx, round, have, &used) != 0) {
+            status = 1;
+            break;
+        }
+
+        // The end of the document needs no newline; a line as long as the whole round is fed as it is
+        if (eof || used == 0) {
+            if (tt2ht_feed(ctx, round + used, have - used) != 0) {
+                status = 1;
+                break;
+            }
+            used = have;
+        }
+        if (src.base != NULL) {
+            src.off += used;
+        } else {
+            memmove(buf, buf + used, have - used);
+            have -= used;
+        }
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = true;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (ctx != NULL && tt2ht_finish(ctx) != 0) {
+        perror("tt2ht: write");
+        status = 1;
+    }
+    for (int i = 0; pool.parts != NULL && i < workers; i++) {
+        free(pool.parts[i].html);
+    }
+    free(pool.parts);
+    free(threads);
+    free(buf);
+    in_close(&src);
+    tt2ht_free(ctx);
+    pthread_cond_destroy(&pool.done);
+    pthread_cond_destroy(&pool.start);
+    pthread_mutex_destroy(&pool.lock);
+    return status;
+}
+
+/**
+ * Read until the buffer is full or the input ends, so every worker gets a whole part
+ * @param fd
+ * @param buf
+ * @param cap
+ * @param have bytes already in buf, updated
+ * @param eof set once read returns 0
+ * @return 0, or -1 if a read failed
+ */
+static int fill(int fd, char *buf, size_t cap, size_t *have, bool *eof) {
+    while (*have < cap) {
+        ssize_t n = read(fd, buf + *have, cap - *have);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            *eof = true;
+            break;
+        }
+        *have += (size_t) n;
+    }
+    return 0;
+}
+
+/**
+ * Convert the whole lines of a round: the lines outside of the table body go through the converter, the body
+ * is rendered by the workers
+ * @param pool
+ * @param ctx
+ * @param buf
+ * @param len
+ * @param used set to how much of buf was converted, always whole lines
+ * @return 0, or -1 if writing or allocating failed
+ */
+static int convert(struct pool *pool, struct tt2ht *ctx, const char *buf, size_t len, size_t *used) {
+    const char *p = buf;
+    const char *last = buf + len;
+
+    while (last > p && last[-1] != '\n') {
+        last--;
+    }
+
+    while (p < last) {
+        const char *nl;
+
+        if (tt2ht_in_body(ctx)) {
+            size_t done;
+
+            if (render_body(pool, ctx, p, (size_t) (last - p), &done) != 0) {
+                perror("tt2ht");
+                return -1;
+            }
+            p += done;
+            if (p == last) {
+                break;
+            }
+        }
+
+        // A tag, or a line before the first row: the converter has to see it
+        nl = memchr(p, '\n', (size_t) (last - p));
+        if (tt2ht_feed(ctx, p, (size_t) (nl - p) + 1) != 0) {
+            perror("tt2ht: write");
+            return -1;
+        }
+        p = nl + 1;
+    }
+    *used = (size_t) (p - buf);
+    return 0;
+}
+
+/**
+ * Cut whole lines of the body into parts, have the workers render them and write the HTML out in order
+ * @param pool
+ * @param ctx
+ * @param body
+ * @param len
+ * @param done set to how much of the body was rows, up to the first tag
+ * @return 0, or -1 if a part ran out of memory
+ */
+static int render_body(struct pool *pool, struct tt2ht *ctx, const char *body, size_t len, size_t *done) {
+    const char *p = body;
+    const char *end = body + len;
+    size_t size = len / (size_t) pool->workers;
+    int count = 0;
+
+    if (size < MIN_PART_SIZE) {
+        size = MIN_PART_SIZE;
+    }
+    while (p < end) {
+        struct part *part = &pool->parts[count++];
+        const char *cut = end;
+
+        // The last part takes whatever is left
+        if (count < pool->workers && (size_t) (end - p) > size) {
+            cut = (const char *) memchr(p + size, '\n', (size_t) (end - p) - size) + 1;
+        }
+        part->bytes = p;
+        part->len = (size_t) (cut - p);
+        p = cut;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->count = count;
+    pool->next = 0;
+    pool->pending = count;
+    pthread_cond_broadcast(&pool->start);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    *done = 0;
+    for (int i = 0; i < count; i++) {
+        struct part *part = &pool->parts[i];
+
+        if (part->out.error) {
+            return -1;
+        }
+        tt2ht_write(ctx, part->html, part->html_len);
+        *done += part->done;
+
+        // The rows after a tag depend on it, so what the later parts made is thrown away
+        if (part->done < part->len) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * A worker: render parts into their buffers until told to quit
+ * @param arg the struct pool
+ * @return NULL
+ */
+static void *work(void *arg) {
+    struct pool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        struct part *part;
+
+        while (!pool->quit && pool->next == pool->count) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        part = &pool->parts[pool->next++];
+        pthread_mutex_unlock(&pool->lock);
+
+        part->html_len = 0;
+        html_init_sink(&part->out, part_sink, part);
+        part->done = tt2ht_rows(pool->ctx, part->bytes, part->len, &part->out);
+        html_flush(&part->out);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * The sink of a part: keep the HTML in the part's buffer, doubling it when it is full
+ * @param arg the struct part
+ * @param buf
+ * @param len
+ * @return 0, or -1 if there was no memory
+ */
+static int part_sink(void *arg, const char *buf, size_t len) {
+    struct part *part = arg;
+
+    if (part->html_len + len > part->html_cap) {
+        size_t cap = part->html_cap ? part->html_cap : HTML_INITIAL_SIZE;
+        char *html;
+
+        while (cap < part->html_len + len) {
+            cap *= 2;
+        }
+        if ((html = realloc(part->html, cap)) == NULL) {
+            return -1;
+        }
+        part->html = html;
+        part->html_cap = cap;
+    }
+    memcpy(part->html + part->html_len, buf, len);
+    part->html_len += len;
+    return 0;
+}
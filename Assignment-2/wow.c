@@ -1,13 +1,13 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include "attrstore.h"
+#include "directive.h"
+#include "linereader.h"
 
-#define MAX_LINE_SIZE           256
-#define MAX_SECTION_SIZE        4096
 #define NO_PROCESS_TAG_START               "<noprocess>"
-#define NO_PROCESS_TAG_END                 "</noprocess>"
 #define ATTRIBUTE_TAG_START             "<attributes>"
-#define ATTRIBUTE_TAG_END               "</attributes>"
 
 enum Status {
     PROCESS_STARTED,
@@ -21,92 +21,89 @@ enum Status {
     NO_STATUS
 } stage;
 
-static bool parse_noprocess(char line[], char const *term);
+static bool parse_noprocess(const char *line, size_t len, const struct directives *dirs);
 
-static bool parse_attributes(char line[], char const *term);
+static bool parse_attributes(const char *line, size_t len, const struct directives *dirs);
 
 int parse_table(char line[]);
 
-void write_to_stdout(char line[], char const *delimiter);
+void write_to_stdout(const char *line, size_t len, const struct directives *dirs);
 
-void write_to_arr(char line[], char const *delimiter);
+void write_to_arr(const char *line, size_t len, const struct directives *dirs);
 
-void clean_up(char attrib[][MAX_SECTION_SIZE]);
+void clean_up(struct attr_store *store);
 
 
-int attributes_counter = -1;
-
-char attributes_array[MAX_LINE_SIZE][MAX_SECTION_SIZE];
+struct attr_store attributes;
 
 int main() {
 
     stage = NO_STATUS;
-    int reader;
-    char line[MAX_LINE_SIZE];
+    struct line_reader lr;
+    const char *line;
+    size_t len;
 
-    while ((reader = getchar()) != EOF) {
-        ungetc(reader, stdin);
+    attr_init(&attributes);
 
-        if (fgets(line, MAX_LINE_SIZE, stdin)) {
+    // Lines of any length, scanned in place when stdin is a file (see linereader.h)
+    if (lr_init(&lr, 0) != 0) {
+        perror("wow");
+        return 1;
+    }
 
+    while (lr_line(&lr, &line, &len)) {
+        struct directives dirs;
 
-            if (stage == NO_STATUS) {
-                parse_noprocess(line, NO_PROCESS_TAG_START);
-            }
+        // All the tags of the line, in one pass
+        dir_scan(line, len, &dirs);
 
-            if (stage == PROCESS_STARTED) {
-                stage = PROCESS_OPEN;
-                continue;
-            }
+        if (stage == NO_STATUS) {
+            parse_noprocess(line, len, &dirs);
+        }
 
-            if (stage == PROCESS_OPEN) {
-                write_to_stdout(line, NO_PROCESS_TAG_END);
-            }
+        if (stage == PROCESS_STARTED) {
+            stage = PROCESS_OPEN;
+            continue;
+        }
 
-            if (stage == PROCESS_OPEN && reader == EOF) {
-                stage = PROCESS_CLOSED;
-            }
+        if (stage == PROCESS_OPEN) {
+            write_to_stdout(line, len, &dirs);
+        }
 
-            if (stage == PROCESS_CLOSED) {
-                parse_attributes(line, ATTRIBUTE_TAG_START);
-                continue;
-            }
+        if (stage == PROCESS_CLOSED) {
+            parse_attributes(line, len, &dirs);
+            continue;
+        }
 
-            if (stage == ATTRIBUTES_IN_PROCESS) {
-                stage = ATTRIBUTES_PROCESSING;
-            }
+        if (stage == ATTRIBUTES_IN_PROCESS) {
+            stage = ATTRIBUTES_PROCESSING;
+        }
 
-            if (stage == ATTRIBUTES_PROCESSING) {
-                write_to_arr(line, ATTRIBUTE_TAG_END);
-            }
+        if (stage == ATTRIBUTES_PROCESSING) {
+            write_to_arr(line, len, &dirs);
+        }
 
-            if (stage == ATTRIBUTES_PROCESSED) {
-                for (int i = 0; i < MAX_LINE_SIZE; i++) {
-                    for (int j = 0; j < MAX_SECTION_SIZE; j++) {
-                        if (attributes_array[i][j] == '\n') {
-                            continue;
-                        } else {
-                            printf("%c", attributes_array[i][j]);
-                        }
-                    }
-
-                }
-                continue;
+        if (stage == ATTRIBUTES_PROCESSED) {
+            for (int i = 0; i < attributes.count; i++) {
+                size_t n;
+                const char *attribute = attr_get(&attributes, i, &n);
+                fwrite(attribute, 1, n, stdout);
             }
-
+            continue;
         }
     }
 
+    lr_free(&lr);
+    attr_free(&attributes);
     return 0;
 }
 
-static bool parse_noprocess(char *line, char const *term) {
-    char *position = strstr(line, term);
-
-    if (position) {
+static bool parse_noprocess(const char *line, size_t len, const struct directives *dirs) {
+    if (DIR_HAS(dirs, DIR_NOPROCESS_START)) {
+        const char *position = dirs->at[DIR_NOPROCESS_START];
         stage = PROCESS_STARTED;
-        unsigned long strip_pos = (position - line) + sizeof(term) + 3;
-        for (unsigned long i = strip_pos; i < MAX_LINE_SIZE; i++) {
+        unsigned long strip_pos = (position - line) + sizeof(NO_PROCESS_TAG_START) - 1;
+        for (unsigned long i = strip_pos; i < len; i++) {
             if (line[i] == '\n' || line[i] == '\0') {
                 break;
             } else {
@@ -119,12 +116,12 @@ static bool parse_noprocess(char *line, char const *term) {
     return false;
 }
 
-static bool parse_attributes(char *line, char const *term) {
-    char *position = strstr(line, term);
-    if (position) {
+static bool parse_attributes(const char *line, size_t len, const struct directives *dirs) {
+    if (DIR_HAS(dirs, DIR_ATTRIBUTES_START)) {
+        const char *position = dirs->at[DIR_ATTRIBUTES_START];
         stage = ATTRIBUTES_IN_PROCESS;
-        unsigned long strip_pos = (position - line) + sizeof(term) + 4;
-        for (unsigned long i = strip_pos; i < MAX_LINE_SIZE; i++) {
+        unsigned long strip_pos = (position - line) + sizeof(ATTRIBUTE_TAG_START) - 1;
+        for (unsigned long i = strip_pos; i < len; i++) {
             if (line[i] == '\n' || line[i] == '\0') {
                 break;
             }
@@ -136,47 +133,33 @@ static bool parse_attributes(char *line, char const *term) {
     return false;
 }
 
-void write_to_stdout(char line[], char const *term) {
-    char *position = strstr(line, term);
-    if (!position && stage == PROCESS_OPEN) {
-        printf("%s", line);
+void write_to_stdout(const char *line, size_t len, const struct directives *dirs) {
+    if (!DIR_HAS(dirs, DIR_NOPROCESS_END) && stage == PROCESS_OPEN) {
+        fwrite(line, 1, len, stdout);
     } else {
         stage = PROCESS_CLOSED;
     }
 }
 
-void write_to_arr(char line[], char const *term) {
-    char *position = strstr(line, term);
-    int status = 0;
-    attributes_counter++;
-    if (!position) {
+void write_to_arr(const char *line, size_t len, const struct directives *dirs) {
+    if (!DIR_HAS(dirs, DIR_ATTRIBUTES_END)) {
         stage = ATTRIBUTES_PROCESSING;
-        for (int i = attributes_counter; i < MAX_LINE_SIZE; i++) {
-            if (status == 1) {
-                continue;
-            }
-            for (int j = 0; (j < MAX_SECTION_SIZE) && status != 1; j++) {
-                attributes_array[i][j] = line[j];
-
-                if (line[j] == '\n') {
-                    status = 1;
-                    continue;
-                }
-
-                if (line[j] == '\0') {
-                    stage = ATTRIBUTES_PROCESSED;
-                    status = 1;
-                    break;
-                }
-            }
+        const char *nl = memchr(line, '\n', len);
+        size_t n = nl ? (size_t) (nl - line) : len;
+        if (attr_add(&attributes, line, n) < 0) {
+            perror("attributes");
+            exit(1);
+        }
+        if (nl == NULL) {
+            stage = ATTRIBUTES_PROCESSED;
         }
     } else {
         stage = ATTRIBUTES_PROCESSED;
     }
 }
 
-void clean_up(char line[][MAX_SECTION_SIZE]) {
-    memset(line, 0, sizeof(line[0][0]) * MAX_LINE_SIZE * MAX_SECTION_SIZE);
+void clean_up(struct attr_store *store) {
+    attr_clear(store);
 }
 
 